@@ -0,0 +1,110 @@
+#ifndef CAN_BITRATE_H
+#define CAN_BITRATE_H
+
+#include <stdint.h>
+
+/*
+ * CAN bit-timing profiles shared by Node 1 (MCP2515, 16 MHz crystal) and
+ * Node 2 (SAM3X8E CAN0, 84 MHz MCK). Both nodes derive their registers from
+ * the same table, so they can not drift apart. Pick a profile by defining
+ * CAN_BITRATE_PROFILE (e.g. -DCAN_BITRATE_PROFILE=CAN_PROFILE_500K) for BOTH
+ * nodes; the default is 125 kbit/s.
+ *
+ * Segment lengths are in time quanta (TQ), SyncSeg (1 TQ) is implicit:
+ *   bit time = (1 + prop + ps1 + ps2) TQ, sample point after 1 + prop + ps1
+ *   MCP2515: TQ = 2 * (BRP + 1) / 16 MHz
+ *   SAM3X:   TQ = (BRP + 1) / 84 MHz
+ * At 1 Mbit/s no TQ count fits both clocks, so every profile lists the
+ * segments per node and the checks below make sure bit rate and sample
+ * point still agree.
+ */
+
+#define CAN_MCP2515_OSC     16000000UL
+#define CAN_SAM_MCK         84000000UL
+
+//                          bit/s     MCP2515: brp prop ps1 ps2 sjw   SAM3X: brp prop ps1 ps2 sjw
+#define CAN_PROFILE_125K    125000UL,          3,   2,   7,  6,  1,          41,  2,   7,  6,  1
+#define CAN_PROFILE_250K    250000UL,          1,   2,   7,  6,  1,          20,  2,   7,  6,  1
+#define CAN_PROFILE_500K    500000UL,          1,   2,   3,  2,  1,          20,  2,   3,  2,  1
+#define CAN_PROFILE_1M     1000000UL,          0,   2,   3,  2,  1,           6,  3,   5,  3,  1
+
+#ifndef CAN_BITRATE_PROFILE
+#define CAN_BITRATE_PROFILE CAN_PROFILE_125K
+#endif
+
+// === Calculators (take a profile, e.g. CAN_MCP_CNF1(CAN_PROFILE_250K)) ===
+// Parameters: rate, MCP2515 brp/prop/ps1/ps2/sjw (mb mp m1 m2 mj), SAM3X (sb sp s1 s2 sj)
+#define CAN__RATE(rate, mb, mp, m1, m2, mj, sb, sp, s1, s2, sj)     (rate)
+#define CAN__MCP_TQ(rate, mb, mp, m1, m2, mj, sb, sp, s1, s2, sj)   (1 + (mp) + (m1) + (m2))
+#define CAN__SAM_TQ(rate, mb, mp, m1, m2, mj, sb, sp, s1, s2, sj)   (1 + (sp) + (s1) + (s2))
+#define CAN__MCP_SP(rate, mb, mp, m1, m2, mj, sb, sp, s1, s2, sj)   (1000UL * (1 + (mp) + (m1)) / (1 + (mp) + (m1) + (m2)))
+#define CAN__SAM_SP(rate, mb, mp, m1, m2, mj, sb, sp, s1, s2, sj)   (1000UL * (1 + (sp) + (s1)) / (1 + (sp) + (s1) + (s2)))
+
+// MCP2515 CNF1: SJW[7:6] BRP[5:0]; CNF2: BTLMODE PHSEG1[5:3] PRSEG[2:0]; CNF3: PHSEG2[2:0]
+#define CAN__MCP_CNF1(rate, mb, mp, m1, m2, mj, sb, sp, s1, s2, sj) ((uint8_t)((((mj) - 1) << 6) | (mb)))
+#define CAN__MCP_CNF2(rate, mb, mp, m1, m2, mj, sb, sp, s1, s2, sj) ((uint8_t)(0x80 | (((m1) - 1) << 3) | ((mp) - 1)))
+#define CAN__MCP_CNF3(rate, mb, mp, m1, m2, mj, sb, sp, s1, s2, sj) ((uint8_t)((m2) - 1))
+
+// SAM3X CAN_BR: BRP[22:16] SJW[13:12] PROPAG[10:8] PHASE1[6:4] PHASE2[2:0], SMP = 0
+#define CAN__SAM_BR(rate, mb, mp, m1, m2, mj, sb, sp, s1, s2, sj) \
+    ((uint32_t)(((uint32_t)(sb) << 16) | (((sj) - 1) << 12) | (((sp) - 1) << 8) | \
+                (((s1) - 1) << 4) | ((s2) - 1)))
+
+// Bit rate each node really gets (integer, for the checks)
+#define CAN__MCP_RATE(rate, mb, mp, m1, m2, mj, sb, sp, s1, s2, sj) (CAN_MCP2515_OSC / (2UL * ((mb) + 1) * (1 + (mp) + (m1) + (m2))))
+#define CAN__SAM_RATE(rate, mb, mp, m1, m2, mj, sb, sp, s1, s2, sj) (CAN_SAM_MCK / (((sb) + 1UL) * (1 + (sp) + (s1) + (s2))))
+
+// Variadic front ends so a profile macro can be passed as one argument
+#define CAN_RATE(...)        CAN__RATE(__VA_ARGS__)
+#define CAN_MCP_CNF1(...)    CAN__MCP_CNF1(__VA_ARGS__)
+#define CAN_MCP_CNF2(...)    CAN__MCP_CNF2(__VA_ARGS__)
+#define CAN_MCP_CNF3(...)    CAN__MCP_CNF3(__VA_ARGS__)
+#define CAN_SAM_BR_OF(...)   CAN__SAM_BR(__VA_ARGS__)
+#define CAN_MCP_TQ(...)      CAN__MCP_TQ(__VA_ARGS__)
+#define CAN_SAM_TQ(...)      CAN__SAM_TQ(__VA_ARGS__)
+#define CAN_MCP_SP(...)      CAN__MCP_SP(__VA_ARGS__)   // Sample point in permille
+#define CAN_SAM_SP(...)      CAN__SAM_SP(__VA_ARGS__)
+#define CAN_MCP_RATE(...)    CAN__MCP_RATE(__VA_ARGS__)
+#define CAN_SAM_RATE(...)    CAN__SAM_RATE(__VA_ARGS__)
+
+// === Selected profile ===
+#define CAN_BITRATE     CAN_RATE(CAN_BITRATE_PROFILE)
+#define CAN_CNF1        CAN_MCP_CNF1(CAN_BITRATE_PROFILE)
+#define CAN_CNF2        CAN_MCP_CNF2(CAN_BITRATE_PROFILE)
+#define CAN_CNF3        CAN_MCP_CNF3(CAN_BITRATE_PROFILE)
+#define CAN_SAM_BR      CAN_SAM_BR_OF(CAN_BITRATE_PROFILE)
+
+// Bits on the wire for a standard data frame with `len` data bytes: 44 + 8*len frame bits,
+// 3 bits interframe space and worst-case stuffing of the 34 + 8*len stuffed bits
+#define CAN_FRAME_BITS(len)     (47 + 8 * (len) + (34 + 8 * (len) - 1) / 4)
+
+// === Checks, for every profile ===
+#define CAN_SP_TOLERANCE    20  // Max sample point difference between the nodes, permille
+
+#define CAN__CHECK(rate, mb, mp, m1, m2, mj, sb, sp, s1, s2, sj) \
+    _Static_assert(CAN__MCP_RATE(rate, mb, mp, m1, m2, mj, sb, sp, s1, s2, sj) == (rate) && \
+                   CAN_MCP2515_OSC % (2UL * ((mb) + 1) * CAN__MCP_TQ(rate, mb, mp, m1, m2, mj, sb, sp, s1, s2, sj) * (rate)) == 0, \
+                   "MCP2515 timing does not give the exact bit rate"); \
+    _Static_assert(CAN__SAM_RATE(rate, mb, mp, m1, m2, mj, sb, sp, s1, s2, sj) == (rate) && \
+                   CAN_SAM_MCK % (((sb) + 1UL) * CAN__SAM_TQ(rate, mb, mp, m1, m2, mj, sb, sp, s1, s2, sj) * (rate)) == 0, \
+                   "SAM3X timing does not give the exact bit rate"); \
+    _Static_assert(CAN__MCP_SP(rate, mb, mp, m1, m2, mj, sb, sp, s1, s2, sj) + CAN_SP_TOLERANCE >= CAN__SAM_SP(rate, mb, mp, m1, m2, mj, sb, sp, s1, s2, sj) && \
+                   CAN__SAM_SP(rate, mb, mp, m1, m2, mj, sb, sp, s1, s2, sj) + CAN_SP_TOLERANCE >= CAN__MCP_SP(rate, mb, mp, m1, m2, mj, sb, sp, s1, s2, sj), \
+                   "Sample points of the two nodes differ too much"); \
+    _Static_assert(CAN__MCP_TQ(rate, mb, mp, m1, m2, mj, sb, sp, s1, s2, sj) >= 8 && CAN__MCP_TQ(rate, mb, mp, m1, m2, mj, sb, sp, s1, s2, sj) <= 25 && \
+                   (mb) <= 63 && (mp) >= 1 && (mp) <= 8 && (m1) >= 1 && (m1) <= 8 && \
+                   (m2) >= 2 && (m2) <= 8 && (mj) >= 1 && (mj) <= 4 && (mj) <= (m2) && \
+                   (mp) + (m1) >= (m2), \
+                   "MCP2515 segments out of range"); \
+    _Static_assert(CAN__SAM_TQ(rate, mb, mp, m1, m2, mj, sb, sp, s1, s2, sj) >= 8 && CAN__SAM_TQ(rate, mb, mp, m1, m2, mj, sb, sp, s1, s2, sj) <= 25 && \
+                   (sb) >= 1 && (sb) <= 127 && (sp) >= 1 && (sp) <= 8 && (s1) >= 1 && (s1) <= 8 && \
+                   (s2) >= 2 && (s2) <= 8 && (sj) >= 1 && (sj) <= 4 && (sj) <= (s2), \
+                   "SAM3X segments out of range")
+#define CAN_CHECK_PROFILE(...) CAN__CHECK(__VA_ARGS__)
+
+CAN_CHECK_PROFILE(CAN_PROFILE_125K);
+CAN_CHECK_PROFILE(CAN_PROFILE_250K);
+CAN_CHECK_PROFILE(CAN_PROFILE_500K);
+CAN_CHECK_PROFILE(CAN_PROFILE_1M);
+
+#endif
@@ -0,0 +1,130 @@
+#ifndef PROTOCOL_H
+#define PROTOCOL_H
+
+#include <stdint.h>
+
+/*
+ * Node 1 <-> Node 2 CAN protocol.
+ *
+ * Every payload is a packed struct that fits in one frame and ends with a
+ * version byte. Frames are built and taken apart with `union_cast` instead
+ * of per-byte offsets, so adding a message only means adding an ID and a
+ * struct here. Both the AVR and the Cortex-M3 are little-endian, so
+ * multi-byte fields have the same layout on the wire and in memory.
+ *
+ * Encode (works for Node 1 can_message_t and Node 2 CanMsg):
+ *    CanMsg m = { PROTO_MSG(PROTO_ID_GAME_OVER, proto_game_over_t, .score = 42) };
+ *
+ * Decode:
+ *    if (PROTO_IS(m, PROTO_ID_JOYSTICK, proto_joystick_t)) {
+ *        proto_joystick_t joy = PROTO_DECODE(proto_joystick_t, m);
+ *    }
+ */
+
+// Bump when a payload layout changes; frames with another version are ignored
+#define PROTO_VERSION               1
+
+// === Message IDs (lower ID wins arbitration) ===
+#define PROTO_ID_JOYSTICK           0x00    // Node 1 -> 2, proto_joystick_t
+#define PROTO_ID_GAME_OVER          0x01    // Node 2 -> 1, proto_game_over_t
+#define PROTO_ID_JOYSTICK_STAMPED   0x02    // Node 1 -> 2, proto_joystick_stamped_t (latency benchmark)
+#define PROTO_ID_LATENCY_ECHO       0x03    // Node 2 -> 1, proto_latency_echo_t
+#define PROTO_ID_DIAG_NODE1         0xF1    // Node 1 -> bus, proto_diag_t (lowest priority)
+#define PROTO_ID_DIAG_NODE2         0xF2    // Node 2 -> bus, proto_diag_t
+
+
+// Strict-aliasing-safe reinterpret-cast
+#define union_cast(type, x) \
+    (((union { \
+        __typeof__(x) a; \
+        type b; \
+    })x).b)
+
+
+// Dummy type for use with `union_cast`: the 8 data bytes of a frame
+typedef struct Byte8 Byte8;
+struct Byte8 {
+    uint8_t bytes[8];
+};
+
+
+// === Payloads ===
+typedef struct {
+    uint8_t x;              // Joystick X (0-100%)
+    uint8_t y;              // Joystick Y (0-100%)
+    uint8_t button;         // Joystick button (0=released, 1=pressed)
+    uint8_t slider_x;       // Slider X (0-255)
+    uint8_t slider_y;       // Slider Y (0-255)
+    uint8_t version;
+} __attribute__((packed)) proto_joystick_t;
+
+typedef struct {
+    uint32_t score;         // Final score of the round
+    uint8_t version;
+} __attribute__((packed)) proto_game_over_t;
+
+// Joystick sample with the Node 1 send time; starts like proto_joystick_t
+typedef struct {
+    uint8_t x;
+    uint8_t y;
+    uint8_t button;
+    uint32_t stamp_us;      // Node 1 cpu_time_microseconds() before the ADC read
+    uint8_t version;
+} __attribute__((packed)) proto_joystick_stamped_t;
+
+// Sent by Node 2 once the stamped sample has been applied
+typedef struct {
+    uint32_t stamp_us;      // Copied from proto_joystick_stamped_t
+    uint16_t service_us;    // Node 2 time from reception to the motor command (next PI step)
+    uint8_t version;
+} __attribute__((packed)) proto_latency_echo_t;
+
+// Periodic bus health summary of one node (counters saturate at 255)
+typedef struct {
+    uint16_t load_permille;     // Estimated bus load over the last period, 0-1000
+    uint8_t tec_peak;           // Highest transmit error counter seen
+    uint8_t rec_peak;           // Highest receive error counter seen
+    uint8_t bus_off;            // Bus-off events
+    uint8_t drops;              // TX frames that never made it onto the bus
+    uint8_t overruns;           // RX frames lost (controller or driver full)
+    uint8_t version;
+} __attribute__((packed)) proto_diag_t;
+
+
+// === Codecs ===
+// Designated initializers for a frame carrying `type`; the version byte is filled in
+#define PROTO_MSG(msg_id, type, ...) \
+    .id = (msg_id), \
+    .length = sizeof(type), \
+    .byte8 = union_cast(Byte8, ((type){ .version = PROTO_VERSION, __VA_ARGS__ }))
+
+// Frame has the right ID, length and protocol version for `type`
+#define PROTO_IS(msg, msg_id, type) \
+    ((msg).id == (msg_id) && \
+     (msg).length == sizeof(type) && \
+     (msg).byte8.bytes[sizeof(type) - 1] == PROTO_VERSION)
+
+// Payload of a frame as `type` (check with PROTO_IS first)
+#define PROTO_DECODE(type, msg)     union_cast(type, (msg).byte8)
+
+// Either joystick layout; both start with x, y, button, so
+// PROTO_DECODE(proto_joystick_t, msg) is valid for those three fields
+#define PROTO_IS_JOYSTICK(msg) \
+    (PROTO_IS(msg, PROTO_ID_JOYSTICK, proto_joystick_t) || \
+     PROTO_IS(msg, PROTO_ID_JOYSTICK_STAMPED, proto_joystick_stamped_t))
+
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "protocol.h assumes a little-endian target"
+#endif
+
+#define PROTO_CHECK_PAYLOAD(type) \
+    _Static_assert(sizeof(type) <= 8, #type " does not fit in a CAN frame")
+
+PROTO_CHECK_PAYLOAD(proto_joystick_t);
+PROTO_CHECK_PAYLOAD(proto_game_over_t);
+PROTO_CHECK_PAYLOAD(proto_joystick_stamped_t);
+PROTO_CHECK_PAYLOAD(proto_latency_echo_t);
+PROTO_CHECK_PAYLOAD(proto_diag_t);
+
+#endif
@@ -0,0 +1,202 @@
+#ifndef TLOG_H
+#define TLOG_H
+
+#include <stdint.h>
+#include <string.h>
+
+/*
+ * Tokenized logging for both nodes.
+ *
+ * TLOG("Joy:%3d Tgt:%4d\n", joy, target) does not format anything on the
+ * device. The format string is placed in flash under a `tlog_fmt_` symbol and
+ * only its address (the token), a millisecond timestamp and the raw arguments
+ * are sent. tools/tlog_decode.py looks the token up in the firmware ELF and
+ * prints the text. Plain printf output on the same UART passes through the
+ * decoder untouched.
+ *
+ * Record (all integers are LEB128 varints):
+ *     token       format string address - TLOG_ID_BASE
+ *     timestamp   milliseconds since start
+ *     arguments   integers as zigzag int32 varints, float/double as 4-byte float
+ * On the wire:   TLOG_FRAME_START, COBS(record), 0x00
+ *
+ * Arguments: up to 8 integers or floats. Integers wider than 32 bits are
+ * truncated; strings and pointers are not supported.
+ *
+ * Each node provides tlog_timestamp_ms() and tlog_output(), and compiles the
+ * encoder once with TLOG_IMPLEMENTATION defined before including this header.
+ */
+
+// 0 compiles every TLOG() away
+#ifndef TLOG_ENABLED
+#define TLOG_ENABLED        1
+#endif
+
+#define TLOG_FRAME_START    0x1E    // ASCII record separator, never part of text output
+#define TLOG_MAX_ARGS       8
+#define TLOG_RECORD_MAX     (3 + 5 + TLOG_MAX_ARGS * 5)     // Token, timestamp, arguments
+#define TLOG_FRAME_MAX      (TLOG_RECORD_MAX + 3)           // Start, COBS overhead, end
+
+// 1: records come from the node's tlog_record_alloc() instead of the stack
+// (node 1 keeps them in external SRAM to spare its 1 KiB of internal RAM).
+// The frame is COBS-encoded in place in the record, so no frame buffer is needed either.
+#ifndef TLOG_RECORD_POOL
+#if defined(__AVR__)
+#define TLOG_RECORD_POOL    1
+#else
+#define TLOG_RECORD_POOL    0
+#endif
+#endif
+
+// Format strings go to flash; the token is their offset from the start of flash
+#if defined(__AVR__)
+#define TLOG_SECTION        __attribute__((section(".progmem.tlog"), used))
+#ifndef TLOG_ID_BASE
+#define TLOG_ID_BASE        0x0000UL
+#endif
+#else
+#define TLOG_SECTION        __attribute__((section(".rodata.tlog"), used))
+#ifndef TLOG_ID_BASE
+#define TLOG_ID_BASE        0x00080000UL    // SAM3X8E IFLASH0
+#endif
+#endif
+
+// Record bytes start at TLOG_RECORD_HEAD, leaving room for the frame start and the
+// first COBS code, so tlog_end() turns the buffer into the frame where it is
+#define TLOG_RECORD_HEAD    2
+
+typedef struct {
+    uint8_t length;                     // Record bytes after TLOG_RECORD_HEAD
+    uint8_t bytes[TLOG_FRAME_MAX];
+} tlog_record_t;
+
+// Encoder (TLOG_IMPLEMENTATION)
+void tlog_begin(tlog_record_t* record, const char* format);
+void tlog_put_int(tlog_record_t* record, int32_t value);
+void tlog_put_float(tlog_record_t* record, float value);
+void tlog_end(tlog_record_t* record);
+uint16_t tlog_drops(void);      // Records tlog_output() had no room for
+
+// Provided by each node
+uint32_t tlog_timestamp_ms(void);
+uint8_t tlog_output(const uint8_t* frame, uint8_t length);     // All or nothing, 0 if dropped
+#if TLOG_RECORD_POOL
+tlog_record_t* tlog_record_alloc(void);                         // NULL drops the record
+void tlog_record_free(tlog_record_t* record);
+#endif
+
+
+// === Macros ===
+#define TLOG_PUT(record, x) \
+    _Generic((x) + 0, float: tlog_put_float, double: tlog_put_float, default: tlog_put_int)(record, (x))
+
+#if TLOG_RECORD_POOL
+#define TLOG_RECORD(format, puts) do { \
+        static const char tlog_fmt_[] TLOG_SECTION = format; \
+        tlog_record_t* tlog_record_ = tlog_record_alloc(); \
+        if (tlog_record_) { \
+            tlog_begin(tlog_record_, tlog_fmt_); \
+            puts \
+            tlog_end(tlog_record_); \
+            tlog_record_free(tlog_record_); \
+        } \
+    } while (0)
+#else
+#define TLOG_RECORD(format, puts) do { \
+        static const char tlog_fmt_[] TLOG_SECTION = format; \
+        tlog_record_t tlog_storage_; \
+        tlog_record_t* tlog_record_ = &tlog_storage_; \
+        tlog_begin(tlog_record_, tlog_fmt_); \
+        puts \
+        tlog_end(tlog_record_); \
+    } while (0)
+#endif
+
+#define TLOG_P(x) TLOG_PUT(tlog_record_, x);
+#define TLOG_1(f)                           TLOG_RECORD(f, )
+#define TLOG_2(f, a)                        TLOG_RECORD(f, TLOG_P(a))
+#define TLOG_3(f, a, b)                     TLOG_RECORD(f, TLOG_P(a) TLOG_P(b))
+#define TLOG_4(f, a, b, c)                  TLOG_RECORD(f, TLOG_P(a) TLOG_P(b) TLOG_P(c))
+#define TLOG_5(f, a, b, c, d)               TLOG_RECORD(f, TLOG_P(a) TLOG_P(b) TLOG_P(c) TLOG_P(d))
+#define TLOG_6(f, a, b, c, d, e)            TLOG_RECORD(f, TLOG_P(a) TLOG_P(b) TLOG_P(c) TLOG_P(d) TLOG_P(e))
+#define TLOG_7(f, a, b, c, d, e, g)         TLOG_RECORD(f, TLOG_P(a) TLOG_P(b) TLOG_P(c) TLOG_P(d) TLOG_P(e) TLOG_P(g))
+#define TLOG_8(f, a, b, c, d, e, g, h)      TLOG_RECORD(f, TLOG_P(a) TLOG_P(b) TLOG_P(c) TLOG_P(d) TLOG_P(e) TLOG_P(g) TLOG_P(h))
+#define TLOG_9(f, a, b, c, d, e, g, h, i)   TLOG_RECORD(f, TLOG_P(a) TLOG_P(b) TLOG_P(c) TLOG_P(d) TLOG_P(e) TLOG_P(g) TLOG_P(h) TLOG_P(i))
+
+#define TLOG_SELECT(_1, _2, _3, _4, _5, _6, _7, _8, _9, name, ...) name
+
+// TLOG(format, args...): format must be a string literal, printf conversions only
+#if TLOG_ENABLED
+#define TLOG(...) TLOG_SELECT(__VA_ARGS__, TLOG_9, TLOG_8, TLOG_7, TLOG_6, TLOG_5, \
+                              TLOG_4, TLOG_3, TLOG_2, TLOG_1, )(__VA_ARGS__)
+#else
+#define TLOG(...) do { } while (0)
+#endif
+
+
+// === Encoder ===
+#ifdef TLOG_IMPLEMENTATION
+
+static uint16_t tlog_dropped;
+
+static void tlog_put_varint(tlog_record_t* record, uint32_t value) {
+    uint8_t* out = &record->bytes[TLOG_RECORD_HEAD];
+    while (value >= 0x80 && record->length < TLOG_RECORD_MAX) {
+        out[record->length++] = (uint8_t)value | 0x80;
+        value >>= 7;
+    }
+    if (record->length < TLOG_RECORD_MAX) {
+        out[record->length++] = (uint8_t)value;
+    }
+}
+
+void tlog_begin(tlog_record_t* record, const char* format) {
+    record->length = 0;
+    tlog_put_varint(record, (uint32_t)((uintptr_t)format - TLOG_ID_BASE));
+    tlog_put_varint(record, tlog_timestamp_ms());
+}
+
+void tlog_put_int(tlog_record_t* record, int32_t value) {
+    // Zigzag: small magnitudes of either sign take one byte
+    tlog_put_varint(record, ((uint32_t)value << 1) ^ (uint32_t)(value >> 31));
+}
+
+void tlog_put_float(tlog_record_t* record, float value) {
+    if (record->length + sizeof(value) > TLOG_RECORD_MAX) return;
+    memcpy(&record->bytes[TLOG_RECORD_HEAD + record->length], &value, sizeof(value));
+    record->length += sizeof(value);
+}
+
+void tlog_end(tlog_record_t* record) {
+    // COBS: every 0x00 is replaced by the distance to the next one, so 0x00 ends the frame.
+    // Each record byte keeps its position in the frame (the zeros become codes), so the
+    // record is encoded where it is; records stay far below COBS's 254-byte block limit.
+    uint8_t* frame = record->bytes;
+    uint8_t end = TLOG_RECORD_HEAD + record->length;
+    uint8_t code_at = 1;
+    uint8_t code = 1;
+    frame[0] = TLOG_FRAME_START;
+    for (uint8_t n = TLOG_RECORD_HEAD; n < end; n++) {
+        if (frame[n] == 0) {
+            frame[code_at] = code;
+            code_at = n;
+            code = 1;
+        } else {
+            code++;
+        }
+    }
+    frame[code_at] = code;
+    frame[end] = 0x00;
+
+    if (!tlog_output(frame, end + 1)) {
+        tlog_dropped++;
+    }
+}
+
+uint16_t tlog_drops(void) {
+    return tlog_dropped;
+}
+
+#endif
+
+#endif
@@ -1,9 +1,26 @@
 #include "adc.h"
+#include "cpu_time/cpu_time.h"
+#include "profile/profile.h"
+#include <avr/interrupt.h>
 
 #ifndef ADC_BASE_ADDR
 #define ADC_BASE_ADDR 0x1000
 #endif
 
+static uint16_t adc_timeouts = 0;
+
+// Sampler state: filter accumulators in 8.8 fixed point, published values double buffered
+static volatile uint8_t adc_sampling = 0;
+static uint8_t adc_primed = 0;                          // A conversion has been started
+static uint16_t adc_filter_state[ADC_CHANNELS];
+static uint8_t adc_filter_shift[ADC_CHANNELS] = {
+    ADC_FILTER_SHIFT_DEFAULT, ADC_FILTER_SHIFT_DEFAULT,
+    ADC_FILTER_SHIFT_DEFAULT, ADC_FILTER_SHIFT_DEFAULT,
+};
+static uint8_t adc_buffer[2][ADC_CHANNELS];
+static volatile uint8_t adc_front = 0;                  // Buffer readers copy from
+static volatile uint8_t adc_seq = 0;                    // Bumped on every publish
+
 void adc_init(void)
 {
     xmem_init();
@@ -28,20 +45,148 @@ void adc_init(void)
     // Set frequency (from repository: OCR0 = 0 gives 0.5 x F_CPU)
     OCR0 = 0;  // This generates the highest frequency (F_CPU/2 = 8MHz)
     
+    // BUSY/INT from the MAX156 as input, pull-up keeps it high if it is not wired
+    ADC_BUSY_DDR &= ~(1 << ADC_BUSY_PIN);
+    ADC_BUSY_PORT |= (1 << ADC_BUSY_PIN);
+    
     // Wait for clock to stabilize
     _delay_ms(10);
 }
 
-// Function to read from MAX156 ADC
-uint8_t adc_read(uint8_t channel)
+// Latest published snapshot; retried if a publish slipped in while copying
+static void adc_copy_snapshot(uint8_t values[ADC_CHANNELS])
+{
+    uint8_t seq;
+    do {
+        seq = adc_seq;
+        const uint8_t *front = adc_buffer[adc_front];
+        for (uint8_t i = 0; i < ADC_CHANNELS; i++) {
+            values[i] = front[i];
+        }
+    } while (seq != adc_seq);
+}
+
+// Start one conversion, wait for BUSY/INT and read the four results in channel order
+uint8_t adc_read_all(uint8_t values[ADC_CHANNELS])
 {
+    PROFILE_SCOPE("adc_read");
+    if (adc_sampling) {
+        adc_copy_snapshot(values);
+        return 1;
+    }
+    
     volatile uint8_t *adc = (volatile uint8_t *)ADC_BASE_ADDR;
-    adc[0] = 0;
-    _delay_us(100);
-    uint8_t value[4] = {0, 0, 0, 0};
-    for (int i = 0; i <= 3; i++)
+    adc[0] = 0;     // WR starts the conversion, BUSY goes high on its rising edge
+    
+    uint8_t done = 0;
+    for (uint8_t us = 0; us < ADC_BUSY_TIMEOUT_US; us++) {
+        if (!(ADC_BUSY_PINREG & (1 << ADC_BUSY_PIN))) {
+            done = 1;
+            break;
+        }
+        _delay_us(1);
+    }
+    if (!done) {
+        adc_timeouts++;
+    }
+    
+    for (uint8_t i = 0; i < ADC_CHANNELS; i++)
     {
-        value[i] = adc[0];
+        values[i] = adc[0];
+    }
+    return done;
+}
+
+uint8_t adc_read(uint8_t channel)
+{
+    uint8_t values[ADC_CHANNELS];
+    adc_read_all(values);
+    return values[channel & (ADC_CHANNELS - 1)];
+}
+
+uint16_t adc_busy_timeouts(void)
+{
+    return adc_timeouts;
+}
+
+// Sampler tick: the conversion started last tick finished long ago (~30 us), so
+// read it, start the next one and never wait on BUSY here
+ISR(TIMER1_COMPA_vect)
+{
+    OCR1A += ADC_SAMPLE_TICKS;
+    
+    volatile uint8_t *adc = (volatile uint8_t *)ADC_BASE_ADDR;
+    if (!adc_primed) {
+        adc[0] = 0;
+        adc_primed = 1;
+        return;
+    }
+    
+    uint8_t raw[ADC_CHANNELS];
+    for (uint8_t i = 0; i < ADC_CHANNELS; i++) {
+        raw[i] = adc[0];
+    }
+    adc[0] = 0;     // Next conversion, read on the next tick
+    
+    uint8_t *back = adc_buffer[adc_front ^ 1];
+    for (uint8_t i = 0; i < ADC_CHANNELS; i++) {
+        uint16_t x = (uint16_t)raw[i] << 8;
+        uint16_t y = adc_filter_state[i];
+        if (x >= y) {
+            y += (x - y) >> adc_filter_shift[i];
+        } else {
+            y -= (y - x) >> adc_filter_shift[i];
+        }
+        adc_filter_state[i] = y;
+        back[i] = (uint8_t)((y + 0x80) >> 8);    // y <= 0xFF00, cannot overflow
+    }
+    adc_front ^= 1;
+    adc_seq++;
+}
+
+void adc_sampler_start(void)
+{
+    if (adc_sampling) return;
+    
+    // Seed filters and both buffers with a real conversion so readers never see zeros
+    uint8_t values[ADC_CHANNELS];
+    adc_read_all(values);
+    for (uint8_t i = 0; i < ADC_CHANNELS; i++) {
+        adc_filter_state[i] = (uint16_t)values[i] << 8;
+        adc_buffer[0][i] = adc_buffer[1][i] = values[i];
+    }
+    
+    if ((TCCR1B & ((1 << CS12) | (1 << CS11) | (1 << CS10))) == 0) {
+        cpu_time_init();    // Timer1 not running yet
+    }
+    
+    uint8_t sreg = SREG;
+    cli();
+    adc_primed = 0;
+    OCR1A = TCNT1 + ADC_SAMPLE_TICKS;
+    TIFR = (1 << OCF1A);
+    TIMSK |= (1 << OCIE1A);
+    adc_sampling = 1;
+    SREG = sreg;
+}
+
+void adc_sampler_stop(void)
+{
+    uint8_t sreg = SREG;
+    cli();
+    TIMSK &= ~(1 << OCIE1A);
+    adc_sampling = 0;
+    SREG = sreg;
+}
+
+uint8_t adc_sampler_running(void)
+{
+    return adc_sampling;
+}
+
+void adc_sampler_set_filter(uint8_t channel, uint8_t shift)
+{
+    if (channel < ADC_CHANNELS) {
+        adc_filter_shift[channel] = shift > ADC_FILTER_SHIFT_MAX ? ADC_FILTER_SHIFT_MAX : shift;
     }
-    return value[channel];
 }
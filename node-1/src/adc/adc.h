@@ -4,5 +4,47 @@
 #include "utils/utils.h"
 #include <util/delay.h>
 
+// MAX156 channels, returned in this order by one conversion
+#define ADC_CHANNELS            4
+
+// MAX156 BUSY/INT (pin 8) -> PD3, low once the conversion is done (see docs/wiring_tables.md)
+#define ADC_BUSY_PIN            PD3
+#define ADC_BUSY_PORT           PORTD
+#define ADC_BUSY_DDR            DDRD
+#define ADC_BUSY_PINREG         PIND
+
+// Give up waiting for BUSY after this long and read anyway (old fixed delay)
+#define ADC_BUSY_TIMEOUT_US     100
+
+// === Background sampler (Timer1 compare A, Timer1 shared with cpu_time) ===
+// Every tick the ISR reads the conversion started on the previous tick, starts the
+// next one, filters each channel and publishes the result into a double buffer.
+// While it runs, adc_read_all/adc_read return the latest filtered snapshot at once.
+#define ADC_SAMPLE_HZ           1000
+#define ADC_SAMPLE_TICKS        (F_CPU / 8 / ADC_SAMPLE_HZ)     // Timer1 runs at F_CPU/8
+
+// IIR low-pass per channel: y += (x - y) / 2^shift, 0 = unfiltered.
+// At 1 kHz, shift 2 settles (63%) in ~4 ms, shift 3 in ~8 ms.
+#define ADC_FILTER_SHIFT_DEFAULT    2
+#define ADC_FILTER_SHIFT_MAX        6
+
 void adc_init(void);
+
+// Start/stop the background sampler (starts Timer1 via cpu_time_init if needed)
+void adc_sampler_start(void);
+void adc_sampler_stop(void);
+uint8_t adc_sampler_running(void);
+
+// Filter strength for one channel (see ADC_FILTER_SHIFT_DEFAULT)
+void adc_sampler_set_filter(uint8_t channel, uint8_t shift);
+
+// One conversion of all four channels into values[0..3]. Returns 0 if BUSY never
+// went low (line not connected?) and the values were read after the timeout.
+// With the sampler running this is a copy of the latest filtered values instead.
+uint8_t adc_read_all(uint8_t values[ADC_CHANNELS]);
+
+// One conversion, one channel. Prefer adc_read_all when more than one channel is needed.
 uint8_t adc_read(uint8_t channel);
+
+// Conversions that ran into ADC_BUSY_TIMEOUT_US
+uint16_t adc_busy_timeouts(void);
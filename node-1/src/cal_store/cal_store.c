@@ -0,0 +1,144 @@
+#include "cal_store.h"
+#include <avr/eeprom.h>
+#include <util/crc16.h>
+#include <avr/pgmspace.h>
+#include "sched/sched.h"
+
+typedef struct {
+    uint8_t version;
+    uint8_t length;
+    uint16_t seq;           // Increments with every save, newest wins
+    uint8_t data[CAL_STORE_DATA_MAX];
+    uint16_t crc;           // Over everything above (header + `length` data bytes)
+} cal_store_slot_t;
+
+_Static_assert(sizeof(cal_store_slot_t) == CAL_STORE_SLOT_SIZE, "cal_store_slot_t must fill one slot");
+
+static cal_store_slot_t cal_store_slots[CAL_STORE_SLOTS] EEMEM;
+
+// Save in progress: the slot image and the next byte of it to write
+static cal_store_slot_t cal_store_pending;
+static uint8_t cal_store_pending_index;
+static uint8_t cal_store_pos = sizeof(cal_store_slot_t);    // Nothing pending
+static uint8_t cal_store_task_id = SCHED_INVALID;
+static const char cal_store_task_name[] PROGMEM = "cal store";
+
+// Start writing the next byte that differs, true once the whole slot is written
+static bool cal_store_write_step(void)
+{
+    uint8_t *dst = (uint8_t *)&cal_store_slots[cal_store_pending_index];
+    const uint8_t *src = (const uint8_t *)&cal_store_pending;
+    while (cal_store_pos < sizeof(cal_store_slot_t)) {
+        if (!eeprom_is_ready()) return false;
+        uint8_t i = cal_store_pos++;
+        if (eeprom_read_byte(dst + i) != src[i]) {
+            eeprom_write_byte(dst + i, src[i]);
+            break;
+        }
+    }
+    return cal_store_pos >= sizeof(cal_store_slot_t);
+}
+
+static void cal_store_task(void)
+{
+    if (cal_store_write_step()) {
+        sched_cancel(cal_store_task_id);
+        cal_store_task_id = SCHED_INVALID;
+    }
+}
+
+// Write the rest of a pending save now
+static void cal_store_finish(void)
+{
+    while (!cal_store_write_step())
+        ;
+}
+
+static uint16_t cal_store_crc(const cal_store_slot_t *slot)
+{
+    const uint8_t *bytes = (const uint8_t *)slot;
+    uint8_t covered = 4 + slot->length;     // Header + data in use
+    uint16_t crc = 0xFFFF;
+    for (uint8_t i = 0; i < covered; i++) {
+        crc = _crc16_update(crc, bytes[i]);
+    }
+    return crc;
+}
+
+// Index of the newest valid slot for this length, -1 if none
+static int8_t cal_store_newest(uint8_t length, cal_store_slot_t *newest)
+{
+    int8_t found = -1;
+    cal_store_slot_t slot;
+    for (uint8_t i = 0; i < CAL_STORE_SLOTS; i++) {
+        eeprom_read_block(&slot, &cal_store_slots[i], sizeof(slot));
+        if (slot.version != CAL_STORE_VERSION || slot.length != length) continue;
+        if (slot.crc != cal_store_crc(&slot)) continue;
+        // Sequence numbers compared with wrap-around
+        if (found < 0 || (int16_t)(slot.seq - newest->seq) > 0) {
+            *newest = slot;
+            found = i;
+        }
+    }
+    return found;
+}
+
+bool cal_store_load(void *data, uint8_t length)
+{
+    if (length > CAL_STORE_DATA_MAX) return false;
+    cal_store_finish();
+
+    cal_store_slot_t slot;
+    if (cal_store_newest(length, &slot) < 0) return false;
+
+    uint8_t *out = data;
+    for (uint8_t i = 0; i < length; i++) {
+        out[i] = slot.data[i];
+    }
+    return true;
+}
+
+bool cal_store_save(const void *data, uint8_t length)
+{
+    if (length > CAL_STORE_DATA_MAX) return false;
+    cal_store_finish();
+
+    cal_store_slot_t slot;
+    int8_t newest = cal_store_newest(length, &slot);
+    uint8_t index = newest < 0 ? 0 : (uint8_t)(newest + 1) % CAL_STORE_SLOTS;
+    uint16_t seq = newest < 0 ? 0 : slot.seq + 1;
+
+    slot = (cal_store_slot_t){
+        .version = CAL_STORE_VERSION,
+        .length = length,
+        .seq = seq,
+    };
+    const uint8_t *in = data;
+    for (uint8_t i = 0; i < length; i++) {
+        slot.data[i] = in[i];
+    }
+    slot.crc = cal_store_crc(&slot);
+
+    // Written in the background, only the bytes that differ
+    cal_store_pending = slot;
+    cal_store_pending_index = index;
+    cal_store_pos = 0;
+    if (cal_store_task_id == SCHED_INVALID) {
+        cal_store_task_id = sched_add(cal_store_task, CAL_STORE_WRITE_MS, 0, SCHED_PRIO_LOW, cal_store_task_name);
+        if (cal_store_task_id == SCHED_INVALID) cal_store_finish();
+    }
+    return true;
+}
+
+bool cal_store_busy(void)
+{
+    return cal_store_pos < sizeof(cal_store_slot_t);
+}
+
+void cal_store_erase(void)
+{
+    cal_store_finish();
+    for (uint8_t i = 0; i < CAL_STORE_SLOTS; i++) {
+        eeprom_update_byte(&cal_store_slots[i].version, 0xFF);
+    }
+}
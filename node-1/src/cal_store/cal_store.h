@@ -0,0 +1,55 @@
+#ifndef CAL_STORE_H
+#define CAL_STORE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Calibration records in the internal EEPROM.
+ *
+ * The EEPROM is split into CAL_STORE_SLOTS slots. Every save goes to the slot
+ * after the newest one, so the wear is spread over all slots and a save cut
+ * short by a reset leaves the previous record intact. Each slot holds a
+ * header (version, length, sequence number) and a CRC-16 over header and data;
+ * loading picks the valid slot with the highest sequence number.
+ *
+ * An EEPROM byte takes about 8.5 ms to write, so a save is written in the
+ * background: a scheduler task writes one changed byte whenever the EEPROM is
+ * ready. Loading or saving again first finishes a write still in progress.
+ */
+
+#define CAL_STORE_SLOTS         8
+#define CAL_STORE_SLOT_SIZE     32      // 8 * 32 = 256 of the 512 EEPROM bytes
+
+// Bump when the stored record layout changes; older records are then ignored
+#define CAL_STORE_VERSION       1
+
+#define CAL_STORE_WRITE_MS      4       // Period of the background write task
+
+// Largest record that fits in a slot next to header and CRC
+#define CAL_STORE_DATA_MAX      (CAL_STORE_SLOT_SIZE - 6)
+
+/**
+ * Copy the newest valid record of `length` bytes into `data`.
+ * Returns false (and leaves `data` alone) if there is none.
+ */
+bool cal_store_load(void *data, uint8_t length);
+
+/**
+ * Start writing the record into the next slot and return. Without a free
+ * scheduler slot it blocks instead (about 8.5 ms per changed byte, up to
+ * ~270 ms for a full slot). Returns false if `length` is too large.
+ */
+bool cal_store_save(const void *data, uint8_t length);
+
+/**
+ * True while a save is still being written.
+ */
+bool cal_store_busy(void);
+
+/**
+ * Invalidate all slots (the next load fails until something is saved).
+ */
+void cal_store_erase(void);
+
+#endif
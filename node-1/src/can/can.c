@@ -1,98 +1,515 @@
 #include "can.h"
+#include "can_stats/can_stats.h"
+#include "profile/profile.h"
+#include "xmem/xmem.h"
+#include "cpu_time/cpu_time.h"
+
+static void can_unpack(const uint8_t* frame, can_message_t* msg);
+static uint8_t can_pack(const can_message_t* msg, uint8_t* frame);
+static void can_tx_kick(void);
+
+// === Receive ring ===
+// Filled by the INT0 chain (single producer), drained by can_receive_message (single consumer).
+// Each side only writes its own index, so no locking is needed.
+static can_message_t can_rx_ring[CAN_RX_RING_SIZE] XMEM_SECTION;
+static volatile uint8_t can_rx_head = 0;    // Written by the ISR
+static volatile uint8_t can_rx_tail = 0;    // Written by the main loop
+static volatile uint16_t can_rx_overflows = 0;
+
+// === Software TX queue ===
+// Kept sorted by priority, FIFO within a level, and fed into TXB0-2 as they become free.
+// The MCP2515 sends the highest-numbered buffer first when TXP is equal, so only one
+// frame per TXP level is in the buffers at a time; that keeps each level in queue order.
+// Shared between the main loop and the INT0 chain, so touched with interrupts off.
+// Frames sit in an external SRAM pool; the queue itself only orders pointers.
+typedef struct {
+    can_message_t msg;
+    uint8_t priority;
+} can_tx_entry_t;
+
+XMEM_POOL_DEFINE(can_tx_pool, can_tx_entry_t, CAN_TX_QUEUE_SIZE);
+static can_tx_entry_t* can_tx_queue[CAN_TX_QUEUE_SIZE];
+static uint8_t can_tx_count = 0;
+static uint8_t can_tx_max_depth = 0;
+static uint16_t can_tx_drops = 0;
+static uint8_t can_tx_busy = 0;             // Bit n: TXBn loaded and waiting for TXnIF
+static uint8_t can_tx_loading = 0;          // Load chain (LOAD TX + CTRL write) in progress
+static uint8_t can_tx_loading_buf;          // TX buffer the load chain is working on
+static uint16_t can_tx_buf_id[3];           // ID and length loaded into TXBn, for the statistics
+static uint8_t can_tx_buf_len[3];
+static uint8_t can_tx_buf_txp[3];           // TXP the frame in TXBn was requested with
+static cpu_ticks_t can_tx_buf_since[3];     // When TXREQ was set in TXBn, for the timeout
+
+#define CAN_TX_TIMEOUT_TICKS ((cpu_ticks_t)CPU_TICKS_PER_SECOND * CAN_TX_TIMEOUT_MS / 1000)
+
+static spi_transaction_t can_tx_txn;
+static uint8_t can_tx_frame[1 + MCP_FRAME_MAX_LEN];  // LOAD TX instruction + buffer content
+static uint8_t can_tx_ctrl[3];                       // WRITE TXBnCTRL, TXREQ | TXP
+
+static void can_irq_retry(void);
+
+static void can_tx_ctrl_done(spi_transaction_t* t) {
+    (void)t;
+    can_tx_buf_since[can_tx_loading_buf] = cpu_time_ticks();
+    can_tx_loading = 0;
+    can_irq_retry();    // A queue slot just freed up
+    can_tx_kick();
+}
+
+static void can_tx_load_done(spi_transaction_t* t) {
+    (void)t;
+    // Data is in place, now request transmission with the frame priority
+    can_tx_txn.tx = can_tx_ctrl;
+    can_tx_txn.tx_len = sizeof(can_tx_ctrl);
+    can_tx_txn.len = sizeof(can_tx_ctrl);
+    can_tx_txn.done = can_tx_ctrl_done;
+    if (!spi_submit(&can_tx_txn)) {
+        // SPI queue full: the buffer was loaded but never requested, free it again
+        can_tx_busy &= ~(1 << can_tx_loading_buf);
+        can_tx_loading = 0;
+        can_tx_drops++;
+    }
+}
+
+// Move the highest priority queued frame into a free TX buffer (interrupts off)
+static void can_tx_kick(void) {
+    if (can_tx_loading || can_tx_count == 0) return;
+    
+    uint8_t n;
+    for (n = 0; n < 3 && (can_tx_busy & (1 << n)); n++)
+        ;
+    if (n == 3) return;     // All three buffers in flight, TXnIF will call us again
+    
+    can_tx_entry_t* e = can_tx_queue[0];
+    uint8_t txp = e->priority & MCP_TXP_MASK;
+    for (uint8_t b = 0; b < 3; b++) {
+        if ((can_tx_busy & (1 << b)) && can_tx_buf_txp[b] == txp) {
+            return;         // An older frame of this level is still in a buffer
+        }
+    }
+    
+    can_tx_frame[0] = MCP_LOAD_TX0 + 2 * n;
+    uint8_t length = 1 + can_pack(&e->msg, &can_tx_frame[1]);
+    can_tx_ctrl[0] = MCP_WRITE;
+    can_tx_ctrl[1] = MCP_TXB0CTRL + 0x10 * n;
+    can_tx_ctrl[2] = MCP_TXREQ | txp;
+    
+    // Pop the head, the frame is in can_tx_frame now
+    xmem_pool_free(&can_tx_pool, e);
+    can_tx_count--;
+    for (uint8_t i = 0; i < can_tx_count; i++) {
+        can_tx_queue[i] = can_tx_queue[i + 1];
+    }
+    
+    can_tx_txn.device = mcp2515_spi_device();
+    can_tx_txn.tx = can_tx_frame;
+    can_tx_txn.tx_len = length;
+    can_tx_txn.rx = 0;
+    can_tx_txn.len = length;
+    can_tx_txn.done = can_tx_load_done;
+    if (spi_submit(&can_tx_txn)) {
+        can_tx_busy |= (1 << n);
+        can_tx_loading = 1;
+        can_tx_loading_buf = n;
+        can_tx_buf_txp[n] = txp;
+        can_tx_buf_id[n] = (can_tx_frame[1] << 3) | (can_tx_frame[2] >> 5);
+        can_tx_buf_len[n] = can_tx_frame[5];
+    } else {
+        can_tx_drops++;
+    }
+}
+
+// Abort frames that sat in a TX buffer past CAN_TX_TIMEOUT_MS (main loop only, it uses
+// blocking MCP2515 access). Clearing TXREQ stops the retries; a frame already on the
+// wire finishes first, so a buffer whose TXREQ is still set is checked again next call.
+// If it went out after all, TXnIF is set and the INT0 chain releases the buffer as usual.
+static void can_tx_expire(void) {
+    for (uint8_t n = 0; n < 3; n++) {
+        uint8_t sreg = SREG;
+        cli();
+        cpu_ticks_t since = can_tx_buf_since[n];
+        uint8_t expired = (can_tx_busy & (1 << n))
+                          && !(can_tx_loading && can_tx_loading_buf == n)
+                          && cpu_time_ticks() - since >= CAN_TX_TIMEOUT_TICKS;
+        SREG = sreg;
+        if (!expired) continue;
+        
+        uint8_t ctrl = MCP_TXB0CTRL + 0x10 * n;
+        mcp2515_bit_modify(ctrl, MCP_TXREQ, 0x00);
+        if (mcp2515_read(ctrl) & MCP_TXREQ) continue;           // Still on the wire
+        if (mcp2515_read(MCP_CANINTF) & (MCP_TX0IF << n)) continue;  // Sent, INT0 frees it
+        
+        // Aborted: TXnIF never comes for this frame, free the buffer here unless the
+        // INT0 chain released it (and maybe reloaded it) while we were on the bus
+        sreg = SREG;
+        cli();
+        if ((can_tx_busy & (1 << n)) && !(can_tx_loading && can_tx_loading_buf == n)
+            && can_tx_buf_since[n] == since) {
+            can_tx_busy &= ~(1 << n);
+            can_tx_drops++;
+            can_tx_kick();
+        }
+        SREG = sreg;
+    }
+}
+
+// === INT0 chain ===
+// INT0 (low level) -> READ STATUS -> READ RXB0 and/or RXB1 (from RXBnCTRL, for FILHIT)
+// -> one BITMOD clearing the handled RXnIF/TXnIF -> refill TX buffers -> INT0 back on.
+// All SPI traffic is queued on the bus manager, so the ISR itself returns at once.
+#define CAN_IRQ_RX_LEN  (2 + 1 + MCP_FRAME_MAX_LEN)     // READ + address, CTRL, buffer
+
+static const uint8_t can_cmd_read_status[] = { MCP_READ_STATUS };
+static const uint8_t can_cmd_read_rxb0[] = { MCP_READ, MCP_RXB0CTRL };
+static const uint8_t can_cmd_read_rxb1[] = { MCP_READ, MCP_RXB1CTRL };
+
+static spi_transaction_t can_irq_txn;
+static uint8_t can_irq_buf[CAN_IRQ_RX_LEN];         // Echo of the command + registers read
+static uint8_t can_irq_cmd[4];                      // BITMOD CANINTF
+static uint8_t can_irq_status;                      // READ STATUS result being worked through
+static uint8_t can_irq_clear;                       // CANINTF bits handled by this chain
+static uint8_t can_irq_tx_done;                     // TX buffers (bit n = TXBn) being released
+static uint8_t can_irq_rx_buffer;                   // RX buffer being read (0/1)
+static volatile uint8_t can_irq_pending = 0;        // can_irq_txn refused by a full SPI queue
+
+// Acceptance filter hits, per hardware filter RXF0-RXF5
+static volatile uint16_t can_filter_hits[6];
+
+static void can_irq_step(void);
+
+static void can_irq_submit(const uint8_t* cmd, uint8_t tx_len, uint8_t len) {
+    can_irq_txn.device = mcp2515_spi_device();
+    can_irq_txn.tx = cmd;
+    can_irq_txn.tx_len = tx_len;
+    can_irq_txn.rx = can_irq_buf;
+    can_irq_txn.len = len;
+    // Queue full: keep the step for can_irq_retry(). INT0 stays off, its level input
+    // would re-fire after every RETI and starve the SPI interrupt that frees the queue.
+    can_irq_pending = !spi_submit(&can_irq_txn);
+}
+
+// Resubmit a chain step the SPI queue refused (interrupts off)
+static void can_irq_retry(void) {
+    if (can_irq_pending && spi_submit(&can_irq_txn)) {
+        can_irq_pending = 0;
+    }
+}
+
+static void can_irq_status_done(spi_transaction_t* t) {
+    (void)t;
+    can_irq_status = can_irq_buf[1];
+    
+    // READ STATUS has TXnIF on bits 3/5/7, CANINTF on bits 2/3/4
+    can_irq_clear = 0;
+    can_irq_tx_done = 0;
+    if (can_irq_status & MCP_STAT_TX0IF) can_irq_tx_done |= 0x01;
+    if (can_irq_status & MCP_STAT_TX1IF) can_irq_tx_done |= 0x02;
+    if (can_irq_status & MCP_STAT_TX2IF) can_irq_tx_done |= 0x04;
+    can_irq_clear = can_irq_tx_done << 2;   // TX0IF..TX2IF
+    can_irq_step();
+}
+
+static void can_irq_clear_done(spi_transaction_t* t) {
+    (void)t;
+    for (uint8_t n = 0; n < 3; n++) {
+        if (can_irq_tx_done & (1 << n)) can_stats_count_tx(can_tx_buf_id[n], can_tx_buf_len[n]);
+    }
+    can_tx_busy &= ~can_irq_tx_done;
+    can_tx_kick();
+    // Done: if INT is still low (new frame meanwhile) INT0 fires again right away
+    GICR |= (1 << INT0);
+}
+
+static void can_irq_rx_done(spi_transaction_t* t) {
+    (void)t;
+    // FILHIT: RXB0CTRL bit 0 (RXF0/1), RXB1CTRL bits 2:0 (RXF0-5, 0/1 after rollover)
+    uint8_t ctrl = can_irq_buf[2];
+    uint8_t filter = can_irq_rx_buffer ? (ctrl & MCP_FILHIT_MASK) : (ctrl & MCP_FILHIT0);
+    if (filter < 6) can_filter_hits[filter]++;
+    
+    const uint8_t* frame = &can_irq_buf[3];
+    uint8_t dlc = frame[4] & 0x0F;
+    can_stats_count_rx(((uint16_t)frame[0] << 3) | (frame[1] >> 5), dlc > 8 ? 8 : dlc);
+    
+    uint8_t next = (can_rx_head + 1) & (CAN_RX_RING_SIZE - 1);
+    if (next == can_rx_tail) {
+        can_rx_overflows++;     // Ring full, the frame is dropped
+    } else {
+        can_unpack(frame, &can_rx_ring[can_rx_head]);
+        can_rx_head = next;
+    }
+    can_irq_step();
+}
+
+// Handle whatever the last status still reports, then clear the flags and finish
+static void can_irq_step(void) {
+    if (can_irq_status & MCP_STAT_RX0IF) {
+        can_irq_status &= ~MCP_STAT_RX0IF;
+        can_irq_clear |= MCP_RX0IF;
+        can_irq_rx_buffer = 0;
+        can_irq_txn.done = can_irq_rx_done;
+        can_irq_submit(can_cmd_read_rxb0, sizeof(can_cmd_read_rxb0), CAN_IRQ_RX_LEN);
+    } else if (can_irq_status & MCP_STAT_RX1IF) {
+        can_irq_status &= ~MCP_STAT_RX1IF;
+        can_irq_clear |= MCP_RX1IF;
+        can_irq_rx_buffer = 1;
+        can_irq_txn.done = can_irq_rx_done;
+        can_irq_submit(can_cmd_read_rxb1, sizeof(can_cmd_read_rxb1), CAN_IRQ_RX_LEN);
+    } else if (can_irq_clear) {
+        can_irq_cmd[0] = MCP_BITMOD;
+        can_irq_cmd[1] = MCP_CANINTF;
+        can_irq_cmd[2] = can_irq_clear;
+        can_irq_cmd[3] = 0x00;
+        can_irq_txn.done = can_irq_clear_done;
+        can_irq_submit(can_irq_cmd, sizeof(can_irq_cmd), sizeof(can_irq_cmd));
+    } else {
+        GICR |= (1 << INT0);
+    }
+}
+
+ISR(INT0_vect)
+{
+    GICR &= ~(1 << INT0);       // Off until the SPI chain has cleared the flags
+    can_irq_txn.done = can_irq_status_done;
+    can_irq_submit(can_cmd_read_status, 1, 2);
+}
+
+// Route the MCP2515 RX/TX interrupts to INT0 (PD2, active low), empty rings and queues
+static void can_irq_init(void) {
+    GICR &= ~(1 << INT0);
+    can_rx_head = can_rx_tail = 0;
+    can_irq_pending = 0;
+    while (can_tx_count > 0) {
+        xmem_pool_free(&can_tx_pool, can_tx_queue[--can_tx_count]);
+    }
+    can_tx_busy = 0;
+    can_tx_loading = 0;
+    can_stats_reset();
+    cpu_time_init();                // Time base of the TX timeout
+    
+    DDRD &= ~(1 << CAN_INT_PIN);    // Input
+    PORTD |= (1 << CAN_INT_PIN);    // Pull-up, the MCP2515 INT pin only pulls low
+    MCUCR &= ~((1 << ISC01) | (1 << ISC00));  // Low level: keeps firing while flags are set
+    
+    mcp2515_write(MCP_CANINTE, MCP_RX_INT | MCP_TX_INT);   // RX0IE | RX1IE | TX0IE..TX2IE
+    GIFR = (1 << INTF0);
+    GICR |= (1 << INT0);
+    sei();
+}
 
 // Initialize CAN controller in loopback mode for testing
 void can_init(void) {
     // Initialize MCP2515 in loopback mode (this already sets up timing)
     mcp2515_init_loopback();
+    can_irq_init();
 }
 
 // Initialize CAN controller in normal mode for actual CAN bus communication
 void can_init_normal(void) {
-    // Initialize MCP2515 in normal mode (250 kbps, real CAN bus)
+    // Initialize MCP2515 in normal mode (125 kbps, real CAN bus)
     mcp2515_init_normal();
+    can_irq_init();
 }
 
-// Send a CAN message
-uint8_t can_send_message(can_message_t* msg) {
-    if (msg == 0 || msg->length > 8) {
-        return 0; // Invalid message
+uint16_t can_rx_overflow_count(void) {
+    uint8_t sreg = SREG;
+    cli();
+    uint16_t count = can_rx_overflows;
+    SREG = sreg;
+    return count;
+}
+
+// Pack a message into the TX buffer layout (SIDH SIDL EID8 EID0 DLC D0..D7), returns byte count
+static uint8_t can_pack(const can_message_t* msg, uint8_t* frame) {
+    // Standard ID format: ID[10:3] goes to SIDH, ID[2:0] goes to SIDL[7:5]
+    frame[0] = (msg->id >> 3) & 0xFF;               // ID[10:3]
+    frame[1] = (msg->id << 5) & 0xE0;               // ID[2:0] shifted to bits 7:5
+    frame[2] = 0x00;                                // EID8 (not used for standard ID)
+    frame[3] = 0x00;                                // EID0 (not used for standard ID)
+    frame[4] = msg->length & 0x0F;                  // DLC (data length)
+    for (uint8_t i = 0; i < msg->length; i++) {
+        frame[MCP_FRAME_HEADER_LEN + i] = msg->data[i];
     }
+    return MCP_FRAME_HEADER_LEN + msg->length;
+}
+
+// Unpack an RX buffer read (same layout) into a message
+static void can_unpack(const uint8_t* frame, can_message_t* msg) {
+    // Reconstruct ID from SIDH and SIDL
+    msg->id = ((uint16_t)frame[0] << 3) | ((frame[1] >> 5) & 0x07);
+    msg->length = frame[4] & 0x0F;  // Data length (lower 4 bits)
+    if (msg->length > 8) msg->length = 8;
+    for (uint8_t i = 0; i < msg->length; i++) {
+        msg->data[i] = frame[MCP_FRAME_HEADER_LEN + i];
+    }
+}
+
+// === Acceptance filters ===
+// Maps each hardware filter RXF0-RXF5 to the table entry it was programmed from
+static uint8_t can_filter_entry[6] = { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };  // 0xFF: no entry
+
+// Program RXF0-RXF5 and RXM0/RXM1 from a table of wanted IDs/ranges.
+// Urgent entries (max 2) go to RXB0 (RXF0-1, RXM0), the rest (max 4) to RXB1 (RXF2-5, RXM1).
+// Each buffer has one mask, so it is the AND of its entries' masks and may let a few
+// more IDs through than asked for. count 0 accepts everything again. Returns 0 if the
+// table does not fit (nothing is changed then).
+uint8_t can_set_filters(const can_filter_t* table, uint8_t count) {
+    uint8_t urgent[2], bulk[4];
+    uint8_t n_urgent = 0, n_bulk = 0;
     
-    // Use TX buffer 0 (starts at address 0x30)
-    // Check if TX buffer is free
-    uint8_t ctrl = mcp2515_read(MCP_TXB0CTRL);
-    if (ctrl & 0x08) {  // TXREQ bit set means buffer is busy
-        // TX buffer stuck? Try to abort and clear errors
-        mcp2515_bit_modify(MCP_TXB0CTRL, 0x08, 0x00);  // Clear TXREQ
-        mcp2515_write(MCP_CANINTF, 0x00);  // Clear all interrupt flags
-        mcp2515_write(MCP_EFLG, 0x00);     // Clear all error flags
-        
-        // Check again
-        ctrl = mcp2515_read(MCP_TXB0CTRL);
-        if (ctrl & 0x08) {
-            return 0; // Still busy, give up
+    for (uint8_t i = 0; i < count; i++) {
+        if (table[i].urgent) {
+            if (n_urgent == 2) return 0;
+            urgent[n_urgent++] = i;
+        } else {
+            if (n_bulk == 4) return 0;
+            bulk[n_bulk++] = i;
         }
     }
     
-    // Load message into TX buffer 0
-    // Standard ID format: ID[10:3] goes to SIDH, ID[2:0] goes to SIDL[7:5]
-    uint8_t sidh = (msg->id >> 3) & 0xFF;           // ID[10:3]
-    uint8_t sidl = (msg->id << 5) & 0xE0;           // ID[2:0] shifted to bits 7:5
+    uint8_t mode = mcp2515_read(MCP_CANSTAT) & MODE_MASK;
+    mcp2515_set_mode(MODE_CONFIG);  // Filters and masks are only writable in config mode
     
-    mcp2515_write(0x31, sidh);                      // TXB0SIDH
-    mcp2515_write(0x32, sidl);                      // TXB0SIDL  
-    mcp2515_write(0x33, 0x00);                      // TXB0EID8 (not used for standard ID)
-    mcp2515_write(0x34, 0x00);                      // TXB0EID0 (not used for standard ID)
-    mcp2515_write(0x35, msg->length & 0x0F);        // TXB0DLC (data length)
+    for (uint8_t f = 0; f < 6; f++) {
+        can_filter_entry[f] = 0xFF;
+        can_filter_hits[f] = 0;
+    }
     
-    // Load data bytes
-    for (uint8_t i = 0; i < msg->length; i++) {
-        mcp2515_write(0x36 + i, msg->data[i]);      // TXB0D0-TXB0D7
+    if (count == 0) {
+        mcp2515_write(MCP_RXB0CTRL, MCP_RXM_ANY | MCP_BUKT);
+        mcp2515_write(MCP_RXB1CTRL, MCP_RXM_ANY);
+        mcp2515_set_mode(mode);
+        return 1;
     }
     
-    // Clear any pending TX interrupt before sending
-    mcp2515_bit_modify(MCP_CANINTF, 0x1C, 0x00);  // Clear TX0IF, TX1IF, TX2IF
+    // An empty group borrows the other group's entries: a buffer without filters
+    // cannot be told to accept nothing
+    const uint8_t* group0 = n_urgent ? urgent : bulk;
+    uint8_t n0 = n_urgent ? n_urgent : 1;
+    const uint8_t* group1 = n_bulk ? bulk : urgent;
+    uint8_t n1 = n_bulk ? n_bulk : 1;
     
-    // Request transmission
-    mcp2515_request_to_send(MCP_RTS_TX0);
+    uint16_t mask0 = 0x7FF, mask1 = 0x7FF;
+    for (uint8_t i = 0; i < n0; i++) mask0 &= table[group0[i]].mask;
+    for (uint8_t i = 0; i < n1; i++) mask1 &= table[group1[i]].mask;
+    mcp2515_write_mask(0, mask0);
+    mcp2515_write_mask(1, mask1);
     
-    return 1; // Success
+    // Unused filters repeat the last entry of their group
+    for (uint8_t f = 0; f < 2; f++) {
+        uint8_t e = group0[f < n0 ? f : n0 - 1];
+        mcp2515_write_filter(f, table[e].id);
+        can_filter_entry[f] = e;
+    }
+    for (uint8_t f = 0; f < 4; f++) {
+        uint8_t e = group1[f < n1 ? f : n1 - 1];
+        mcp2515_write_filter(2 + f, table[e].id);
+        can_filter_entry[2 + f] = e;
+    }
+    
+    mcp2515_write(MCP_RXB0CTRL, MCP_BUKT);     // RXM = 00: filtered, rollover into RXB1
+    mcp2515_write(MCP_RXB1CTRL, 0x00);
+    mcp2515_set_mode(mode);
+    return 1;
+}
+
+// Frames accepted for a table entry (sum over the hardware filters it was loaded into)
+uint16_t can_filter_hit_count(uint8_t entry) {
+    uint16_t hits = 0;
+    uint8_t sreg = SREG;
+    cli();
+    for (uint8_t f = 0; f < 6; f++) {
+        if (can_filter_entry[f] == entry) hits += can_filter_hits[f];
+    }
+    SREG = sreg;
+    return hits;
 }
 
-// Receive a CAN message
+// Queue a CAN message for transmission, never blocks and never aborts a frame in flight
+// (only the TX timeout in can_tx_expire does).
+// On a full queue a frame of higher priority than the tail evicts it (counted as the drop);
+// otherwise returns 0 (and counts a drop) if the message is invalid or the queue is full.
+uint8_t can_send_message_priority(can_message_t* msg, uint8_t priority) {
+    PROFILE_SCOPE("can_send_message");
+    if (msg == 0 || msg->length > 8) {
+        return 0; // Invalid message
+    }
+    
+    uint8_t sreg = SREG;
+    cli();
+    if (can_tx_count == CAN_TX_QUEUE_SIZE && can_tx_queue[can_tx_count - 1]->priority < priority) {
+        // Make room: the tail is the newest frame of the lowest queued level
+        xmem_pool_free(&can_tx_pool, can_tx_queue[--can_tx_count]);
+        can_tx_drops++;
+    }
+    can_tx_entry_t* e = xmem_pool_alloc(&can_tx_pool);
+    if (e == NULL) {
+        can_tx_drops++;
+        SREG = sreg;
+        return 0;
+    }
+    e->msg = *msg;
+    e->priority = priority;
+    
+    // Insert behind every entry of the same or higher priority
+    uint8_t pos = can_tx_count;
+    while (pos > 0 && can_tx_queue[pos - 1]->priority < priority) {
+        can_tx_queue[pos] = can_tx_queue[pos - 1];
+        pos--;
+    }
+    can_tx_queue[pos] = e;
+    can_tx_count++;
+    if (can_tx_count > can_tx_max_depth) can_tx_max_depth = can_tx_count;
+    
+    can_tx_kick();
+    SREG = sreg;
+    
+    return 1; // Queued
+}
+
+// Send a CAN message at normal priority
+uint8_t can_send_message(can_message_t* msg) {
+    return can_send_message_priority(msg, CAN_PRIO_NORMAL);
+}
+
+void can_tx_stats(can_tx_stats_t* stats) {
+    uint8_t sreg = SREG;
+    cli();
+    stats->depth = can_tx_count;
+    stats->max_depth = can_tx_max_depth;
+    stats->drops = can_tx_drops;
+    stats->in_flight = (can_tx_busy & 1) + ((can_tx_busy >> 1) & 1) + ((can_tx_busy >> 2) & 1);
+    SREG = sreg;
+}
+
+// Receive a CAN message: non-blocking dequeue from the INT0-filled ring, 0 if empty
 uint8_t can_receive_message(can_message_t* msg) {
     if (msg == 0) {
         return 0; // Invalid pointer
     }
     
-    // Check if message is available in RX buffer 0
-    uint8_t canintf = mcp2515_read(MCP_CANINTF);
-    if (!(canintf & MCP_RX0IF)) {
-        return 0; // No message pending
+    // Polled often, so it also restarts an interrupt chain stalled on a full SPI queue
+    // and aborts TX buffers that were never ACKed
+    if (can_irq_pending) {
+        uint8_t sreg = SREG;
+        cli();
+        can_irq_retry();
+        SREG = sreg;
     }
+    can_tx_expire();
     
-    // Read message from RX buffer 0 (starts at 0x61)
-    uint8_t sidh = mcp2515_read(MCP_RXB0SIDH + 0);  // RXB0SIDH
-    uint8_t sidl = mcp2515_read(MCP_RXB0SIDH + 1);  // RXB0SIDL
-    uint8_t dlc = mcp2515_read(MCP_RXB0SIDH + 4);   // RXB0DLC
-    
-    // Reconstruct ID from SIDH and SIDL
-    msg->id = ((uint16_t)sidh << 3) | ((sidl >> 5) & 0x07);
-    msg->length = dlc & 0x0F;  // Data length (lower 4 bits)
-    
-    // Read data bytes
-    for (uint8_t i = 0; i < msg->length && i < 8; i++) {
-        msg->data[i] = mcp2515_read(MCP_RXB0SIDH + 5 + i);  // RXB0D0-RXB0D7
+    uint8_t tail = can_rx_tail;
+    if (tail == can_rx_head) {
+        return 0; // No message pending
     }
     
-    // Clear the interrupt flag to indicate message has been read
-    mcp2515_bit_modify(MCP_CANINTF, MCP_RX0IF, 0x00);
+    *msg = can_rx_ring[tail];
+    can_rx_tail = (tail + 1) & (CAN_RX_RING_SIZE - 1);  // Publish the free slot last
     
     return 1; // Success
 }
 
-// Check if a message is pending
+// Check if a message is waiting in the ring
 uint8_t can_message_pending(void) {
-    uint8_t canintf = mcp2515_read(MCP_CANINTF);
-    return (canintf & MCP_RX0IF) ? 1 : 0;
-}
\ No newline at end of file
+    return can_rx_tail != can_rx_head;
+}
@@ -5,19 +5,63 @@
 #include "utils/utils.h"
 #include <util/delay.h>
 #include "mcp2515/mcp2515.h"
+#include "protocol.h"
+#include <avr/io.h>
+#include <avr/interrupt.h>
+
+// MCP2515 INT -> PD2 (INT0), see docs/wiring_tables.md
+#define CAN_INT_PIN         PD2
+
+// Received frames waiting for can_receive_message (power of two)
+#define CAN_RX_RING_SIZE    8
+
+// Frames waiting for a free TX buffer
+#define CAN_TX_QUEUE_SIZE   8
+
+// A requested frame not ACKed within this time (no peer, error passive) is aborted
+// and counted as a drop, so its TX buffer and priority level do not block forever
+#define CAN_TX_TIMEOUT_MS   20
+
+// TX priority (MCP2515 TXP): control frames should outrank telemetry
+#define CAN_PRIO_LOW        0
+#define CAN_PRIO_NORMAL     1
+#define CAN_PRIO_HIGH       2
+#define CAN_PRIO_CONTROL    3
 
 // CAN message structure
 typedef struct {
     uint16_t id;           // CAN message ID (11-bit standard ID)
     uint8_t length;        // Data length (0-8 bytes)
-    uint8_t data[8];       // Message data
+    union {
+        uint8_t data[8];   // Message data
+        Byte8 byte8;       // Same bytes, for PROTO_MSG / PROTO_DECODE (protocol.h)
+    };
 } can_message_t;
 
+// Acceptance filter table entry: frames with (frame_id & mask) == (id & mask) are kept
+typedef struct {
+    uint16_t id;
+    uint16_t mask;          // 0x7FF: exactly id, 0x7F0: id..id+15 (id aligned), ...
+    uint8_t urgent;         // 1: RXB0 (read first), 0: RXB1 (bulk)
+} can_filter_t;
+
+typedef struct {
+    uint8_t depth;          // Frames queued right now
+    uint8_t max_depth;      // Highest depth seen
+    uint8_t in_flight;      // TX buffers loaded and not yet sent
+    uint16_t drops;         // Frames refused, evicted (queue full) or aborted (TX timeout)
+} can_tx_stats_t;
+
 // CAN driver function declarations
 void can_init(void);                                    // Initialize CAN controller in loopback mode
 void can_init_normal(void);                             // Initialize CAN controller in normal mode (real CAN bus)
-uint8_t can_send_message(can_message_t* msg);          // Send a CAN message
-uint8_t can_receive_message(can_message_t* msg);       // Receive a CAN message
+uint8_t can_send_message(can_message_t* msg);          // Queue a CAN message (normal priority)
+uint8_t can_send_message_priority(can_message_t* msg, uint8_t priority); // Queue with CAN_PRIO_*
+void can_tx_stats(can_tx_stats_t* stats);              // TX queue depth and drop counters
+uint8_t can_receive_message(can_message_t* msg);       // Take a received message, 0 if none (also expires stuck TX buffers)
 uint8_t can_message_pending(void);                     // Check if message is pending
+uint16_t can_rx_overflow_count(void);                  // Frames dropped because the ring was full
+uint8_t can_set_filters(const can_filter_t* table, uint8_t count); // Program RXF/RXM, 0 if it does not fit
+uint16_t can_filter_hit_count(uint8_t entry);          // Frames accepted for a table entry (FILHIT)
 
 #endif
\ No newline at end of file
@@ -0,0 +1,159 @@
+#include "can_stats.h"
+#include "cpu_time/cpu_time.h"
+#include <avr/pgmspace.h>
+
+// Counters touched by the INT0 chain (interrupts off), everything else by can_stats_service
+static can_stats_t can_stats;
+static uint32_t can_stats_window_bits;      // Wire bits since the window started
+static uint32_t can_stats_window_start_ms;
+static uint8_t can_stats_bus_off_now;       // TXBO seen at the last sample
+static proto_diag_t can_stats_peer;         // Last diagnostics frame from Node 2
+static uint8_t can_stats_peer_valid;
+
+static uint8_t can_stats_sat8(uint16_t value) {
+    return value > 0xFF ? 0xFF : (uint8_t)value;
+}
+
+// Slot for an ID, a new slot while there is room, else the shared last one
+static can_stats_id_t* can_stats_slot(uint16_t id) {
+    for (uint8_t i = 0; i < can_stats.id_count; i++) {
+        if (can_stats.ids[i].id == id) return &can_stats.ids[i];
+    }
+    if (can_stats.id_count < CAN_STATS_IDS - 1) {
+        can_stats_id_t* slot = &can_stats.ids[can_stats.id_count++];
+        slot->id = id;
+        return slot;
+    }
+    can_stats_id_t* other = &can_stats.ids[CAN_STATS_IDS - 1];
+    if (can_stats.id_count < CAN_STATS_IDS) {
+        can_stats.id_count = CAN_STATS_IDS;
+        other->id = CAN_STATS_OTHER_ID;
+    }
+    return other;
+}
+
+void can_stats_reset(void) {
+    uint8_t sreg = SREG;
+    cli();
+    can_stats = (can_stats_t){0};
+    can_stats_window_bits = 0;
+    can_stats_window_start_ms = (uint32_t)cpu_time_milliseconds();
+    can_stats_bus_off_now = 0;
+    SREG = sreg;
+}
+
+void can_stats_count_tx(uint16_t id, uint8_t length) {
+    can_stats_slot(id)->tx++;
+    can_stats_window_bits += CAN_FRAME_BITS(length);
+}
+
+void can_stats_count_rx(uint16_t id, uint8_t length) {
+    can_stats_slot(id)->rx++;
+    can_stats_window_bits += CAN_FRAME_BITS(length);
+}
+
+// TEC, REC and EFLG: peaks, bus-off edges and hardware overruns
+static void can_stats_sample_errors(void) {
+    uint8_t counters[2];
+    mcp2515_read_burst(MCP_TEC, counters, 2);   // TEC, REC
+    uint8_t eflg = mcp2515_read(MCP_EFLG);
+
+    uint8_t overruns = ((eflg & MCP_EFLG_RX0OVR) ? 1 : 0) + ((eflg & MCP_EFLG_RX1OVR) ? 1 : 0);
+    if (overruns) {
+        mcp2515_bit_modify(MCP_EFLG, MCP_EFLG_RX0OVR | MCP_EFLG_RX1OVR, 0x00);
+    }
+    uint8_t bus_off = (eflg & MCP_EFLG_TXBO) != 0;
+
+    uint8_t sreg = SREG;
+    cli();
+    can_stats.tec = counters[0];
+    can_stats.rec = counters[1];
+    if (counters[0] > can_stats.tec_peak) can_stats.tec_peak = counters[0];
+    if (counters[1] > can_stats.rec_peak) can_stats.rec_peak = counters[1];
+    can_stats.rx_overruns += overruns;
+    if (bus_off && !can_stats_bus_off_now) can_stats.bus_off++;
+    SREG = sreg;
+    can_stats_bus_off_now = bus_off;
+}
+
+void can_stats_service(void) {
+    uint32_t now = (uint32_t)cpu_time_milliseconds();
+    uint32_t elapsed = now - can_stats_window_start_ms;
+    if (elapsed < CAN_STATS_PERIOD_MS) return;
+
+    can_stats_sample_errors();
+
+    can_tx_stats_t tx;
+    can_tx_stats(&tx);
+    uint16_t rx_overflows = can_rx_overflow_count();
+
+    uint8_t sreg = SREG;
+    cli();
+    uint32_t bits = can_stats_window_bits;
+    can_stats_window_bits = 0;
+    SREG = sreg;
+    can_stats_window_start_ms = now;
+
+    // bits / (bit/s * s), in permille
+    uint32_t load = bits * 1000UL / (CAN_BITRATE / 1000UL * elapsed);
+    if (load > 1000) load = 1000;
+
+    cli();
+    can_stats.tx_drops = tx.drops;
+    can_stats.rx_overflows = rx_overflows;
+    can_stats.load_permille = (uint16_t)load;
+    if (load > can_stats.load_peak_permille) can_stats.load_peak_permille = (uint16_t)load;
+    can_message_t diag = {
+        PROTO_MSG(PROTO_ID_DIAG_NODE1, proto_diag_t,
+            .load_permille = (uint16_t)load,
+            .tec_peak = can_stats.tec_peak,
+            .rec_peak = can_stats.rec_peak,
+            .bus_off = can_stats_sat8(can_stats.bus_off),
+            .drops = can_stats_sat8(can_stats.tx_drops),
+            .overruns = can_stats_sat8(can_stats.rx_overflows + can_stats.rx_overruns))
+    };
+    SREG = sreg;
+
+    can_send_message_priority(&diag, CAN_PRIO_LOW);
+}
+
+uint8_t can_stats_peer_frame(const can_message_t* msg) {
+    if (!PROTO_IS(*msg, PROTO_ID_DIAG_NODE2, proto_diag_t)) return 0;
+    can_stats_peer = PROTO_DECODE(proto_diag_t, *msg);
+    can_stats_peer_valid = 1;
+    return 1;
+}
+
+void can_stats_get(can_stats_t* stats) {
+    uint8_t sreg = SREG;
+    cli();
+    *stats = can_stats;
+    SREG = sreg;
+}
+
+void can_stats_print(void) {
+    can_stats_t s;
+    can_stats_get(&s);
+
+    printf_P(PSTR("\r\n=== CAN stats (%lu kbps) ===\r\n"), CAN_BITRATE / 1000);
+    for (uint8_t i = 0; i < s.id_count; i++) {
+        if (s.ids[i].id == CAN_STATS_OTHER_ID) {
+            printf_P(PSTR("ID other  TX %8lu  RX %8lu\r\n"), s.ids[i].tx, s.ids[i].rx);
+        } else {
+            printf_P(PSTR("ID 0x%03X  TX %8lu  RX %8lu\r\n"), s.ids[i].id, s.ids[i].tx, s.ids[i].rx);
+        }
+    }
+    printf_P(PSTR("Load %u.%u%% (peak %u.%u%%)\r\n"),
+             s.load_permille / 10, s.load_permille % 10,
+             s.load_peak_permille / 10, s.load_peak_permille % 10);
+    printf_P(PSTR("TEC %u (peak %u)  REC %u (peak %u)  bus-off %u\r\n"),
+             s.tec, s.tec_peak, s.rec, s.rec_peak, s.bus_off);
+    printf_P(PSTR("TX drops %u  RX ring overflows %u  RX overruns %u\r\n"),
+             s.tx_drops, s.rx_overflows, s.rx_overruns);
+    if (can_stats_peer_valid) {
+        printf_P(PSTR("Node 2: load %u.%u%%  TEC peak %u  REC peak %u  bus-off %u  drops %u  overruns %u\r\n"),
+                 can_stats_peer.load_permille / 10, can_stats_peer.load_permille % 10,
+                 can_stats_peer.tec_peak, can_stats_peer.rec_peak, can_stats_peer.bus_off,
+                 can_stats_peer.drops, can_stats_peer.overruns);
+    }
+}
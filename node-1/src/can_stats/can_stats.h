@@ -0,0 +1,83 @@
+#ifndef CAN_STATS_H
+#define CAN_STATS_H
+
+#include <stdint.h>
+#include "can/can.h"
+#include "protocol.h"
+
+/*
+ * CAN bus health and throughput counters.
+ *
+ * The CAN driver reports every frame that went out or came in; the main loop
+ * calls can_stats_service() which once per period samples the MCP2515 error
+ * state, turns the frame sizes into a bus load estimate and publishes a
+ * PROTO_ID_DIAG_NODE1 frame. It does not read the UART: whoever owns the
+ * console (game_menu's service task) calls can_stats_print() when
+ * CAN_STATS_QUERY arrives.
+ *
+ * The load only covers frames this node sent or accepted, so with
+ * acceptance filters set it is a lower bound for the whole bus.
+ */
+
+// Distinct IDs counted separately, any further IDs share the last slot
+#define CAN_STATS_IDS           8
+#define CAN_STATS_OTHER_ID      0xFFFF
+
+// Load window and diagnostics frame period
+#define CAN_STATS_PERIOD_MS     1000
+
+// UART command the console owner answers with can_stats_print()
+#define CAN_STATS_QUERY         's'
+
+typedef struct {
+    uint16_t id;                // CAN_STATS_OTHER_ID for the overflow slot
+    uint32_t tx;                // Frames sent (acknowledged on the bus)
+    uint32_t rx;                // Frames received
+} can_stats_id_t;
+
+typedef struct {
+    can_stats_id_t ids[CAN_STATS_IDS];
+    uint8_t id_count;           // Slots in use
+    uint16_t tx_drops;          // Frames the driver could not queue or load
+    uint16_t rx_overflows;      // Frames dropped because the driver ring was full
+    uint16_t rx_overruns;       // Frames lost in the MCP2515 (EFLG RXnOVR)
+    uint8_t tec, rec;           // Error counters at the last sample
+    uint8_t tec_peak, rec_peak;
+    uint16_t bus_off;           // Bus-off events
+    uint16_t load_permille;     // Estimated bus load over the last period
+    uint16_t load_peak_permille;
+} can_stats_t;
+
+/**
+ * Clear all counters and start a new load window.
+ */
+void can_stats_reset(void);
+
+/**
+ * Count a frame that was sent / received (called by the CAN driver, interrupts off).
+ */
+void can_stats_count_tx(uint16_t id, uint8_t length);
+void can_stats_count_rx(uint16_t id, uint8_t length);
+
+/**
+ * Call from the main loop: sample error state, update the load estimate and send
+ * the diagnostics frame every CAN_STATS_PERIOD_MS.
+ */
+void can_stats_service(void);
+
+/**
+ * Keep the other node's diagnostics frame for can_stats_print, returns 1 if msg was one.
+ */
+uint8_t can_stats_peer_frame(const can_message_t* msg);
+
+/**
+ * Consistent copy of the counters.
+ */
+void can_stats_get(can_stats_t* stats);
+
+/**
+ * Print the counters over UART.
+ */
+void can_stats_print(void);
+
+#endif
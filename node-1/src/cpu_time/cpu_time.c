@@ -1,14 +1,33 @@
 #include "cpu_time.h"
 
+// Timer1 overflows (every 65536 ticks = 106 2/3 ms) and the time they add up to.
+// The 2/3 of a ms/us per overflow is carried in t1_thirds, so there is no division
+// left when reading the time.
 volatile long t1_ovf = 0;
+static volatile uint32_t t1_us = 0;
+static volatile uint32_t t1_ms = 0;
+static volatile uint8_t t1_thirds = 0;
 
 ISR(TIMER1_OVF_vect)
 {
     t1_ovf++;
+    t1_us += CPU_TIME_OVF_US;
+    t1_ms += CPU_TIME_OVF_MS;
+    t1_thirds += 2;
+    if (t1_thirds >= 3) {
+        t1_thirds -= 3;
+        t1_us++;
+        t1_ms++;
+    }
 }
 
 void cpu_time_init(void)
 {
+    // Already running: keep counting, other modules (ADC sampler) use Timer1 too
+    if (TCCR1B & (1 << CS11)) {
+        return;
+    }
+    
     cli();
     TCCR1A = 0; // normal mode
     TCCR1B = 0;
@@ -18,33 +37,54 @@ void cpu_time_init(void)
     sei();
 }
 
-long cpu_time_microseconds(void)
+// The readers below take the overflow-side value and TCNT1 with interrupts off. An
+// overflow that happened after that (TOV1 pending, TCNT1 already wrapped) is added
+// by hand, exactly as the ISR would add it.
+
+cpu_ticks_t cpu_time_ticks(void)
 {
-    long ovf;
-    long cnt;
-    long s = SREG;
+    uint8_t sreg = SREG;
     cli();
-    ovf = t1_ovf;
-    cnt = TCNT1;
-    // handle pending overflow that occurred just after reading TCNT1
-    if (TIFR & (1 << TOV1))
-    {
+    uint16_t ovf = (uint16_t)t1_ovf;
+    uint16_t cnt = TCNT1;
+    if ((TIFR & (1 << TOV1)) && cnt < 0x8000) {
         ovf++;
-        cnt = TCNT1;
     }
-    SREG = s;
+    SREG = sreg;
+    return ((cpu_ticks_t)ovf << 16) | cnt;
+}
 
-    long ticks = (ovf << 16) | cnt; // 16-bit Timer1
-    // µs = ticks * (prescaler * 1e6 / F_CPU)
-    return (long)((ticks * 8ULL * 1000000ULL) / F_CPU);
+long cpu_time_microseconds(void)
+{
+    uint8_t sreg = SREG;
+    cli();
+    uint32_t us = t1_us;
+    uint16_t cnt = TCNT1;
+    if ((TIFR & (1 << TOV1)) && cnt < 0x8000) {
+        us += CPU_TIME_OVF_US + (t1_thirds >= 1);   // What the pending ISR would add
+    }
+    SREG = sreg;
+    
+    // cnt * 625 / 384 (1 tick = 1.6276 us) as a multiply and shift, rounds down
+    return (long)(us + (uint32_t)(((uint32_t)cnt * 53333UL) >> 15));
 }
 
 long cpu_time_milliseconds(void)
 {
-    return cpu_time_microseconds() / 1000;
+    uint8_t sreg = SREG;
+    cli();
+    uint32_t ms = t1_ms;
+    uint16_t cnt = TCNT1;
+    if ((TIFR & (1 << TOV1)) && cnt < 0x8000) {
+        ms += CPU_TIME_OVF_MS + (t1_thirds >= 1);
+    }
+    SREG = sreg;
+    
+    // cnt / 614.4 as a multiply and shift, rounds down
+    return (long)(ms + (uint16_t)(((uint32_t)cnt * 6827UL) >> 22));
 }
 
 double cpu_time_seconds(void)
 {
-    return (double)(cpu_time_microseconds() / 1000000);
+    return cpu_time_milliseconds() / 1000.0;
 }
@@ -1,13 +1,36 @@
+#pragma once
+
 #include <time.h>
+#include <stdint.h>
 #include <avr/io.h>
 #include "utils/utils.h"
 #include <avr/interrupt.h>
 
+// Timer1 runs at F_CPU / 8 = 614400 ticks per second (1 tick = 1.6276 us)
+#define CPU_TICKS_PER_SECOND    (F_CPU / 8)
+
+// Time per Timer1 overflow (65536 ticks = 106 2/3 ms), whole part
+#define CPU_TIME_OVF_US         106666UL
+#define CPU_TIME_OVF_MS         106UL
+
+// Raw Timer1 ticks, wraps after ~1.9 hours; differences of up to that are valid
+typedef uint32_t cpu_ticks_t;
+
+// Exact tick <-> microsecond conversion (64-bit math: for reports, not hot paths)
+#define CPU_TICKS_TO_US(ticks)  ((uint32_t)(((uint64_t)(ticks) * 625) / 384))
+#define CPU_US_TO_TICKS(us)     ((cpu_ticks_t)(((uint64_t)(us) * 384) / 625))
+
 /**
- * Initializes the cpu time module on Timer1.
+ * Initializes the cpu time module on Timer1 (does nothing if it is already running).
  */
 void cpu_time_init(void);
 
+/**
+ * Raw tick count: a few instructions with interrupts off, no arithmetic.
+ * Use this in hot paths and convert differences with CPU_TICKS_TO_US.
+ */
+cpu_ticks_t cpu_time_ticks(void);
+
 /**
  * Returns the number of seconds since the cpu started.
  */
@@ -2,46 +2,136 @@
 
 // === Private Helper Functions ===
 
-static void ioboard_delay_us(uint16_t microseconds) {
-    // Simple delay function for SPI timing requirements
-    while (microseconds--) {
-        _delay_us(1);
+// I/O board on the shared SPI bus: CS on PB4 (SPI_SS), fck/16, mode 0.
+// The 40us/2us gaps between bytes are timed by the SPI bus manager.
+static const spi_device_t ioboard_spi = SPI_DEVICE(PORTB, SPI_SS, 16, 0,
+                                                   IOBOARD_CMD_DATA_DELAY_US, IOBOARD_DATA_DELAY_US);
+
+// Clock len bytes through the I/O board (tx_len of them from tx) and wait for the result
+static void ioboard_transfer(const uint8_t* tx, uint8_t tx_len, uint8_t* rx, uint8_t len) {
+    spi_transaction_t t = {
+        .device = &ioboard_spi,
+        .tx = tx,
+        .tx_len = tx_len,
+        .rx = rx,
+        .len = len,
+    };
+    // Queue full: wait for room, the callers have no way to tell an empty frame from a reading
+    while (!spi_submit(&t))
+        ;
+    spi_wait(&t);
+}
+
+// === Background polling ===
+
+// Reads in rotation order
+static const uint8_t ioboard_poll_commands[] = {
+    IOBOARD_CMD_BUTTONS,
+    IOBOARD_CMD_TOUCHPAD,
+    IOBOARD_CMD_TOUCHSLIDER,
+};
+#define IOBOARD_POLL_COUNT (sizeof(ioboard_poll_commands) / sizeof(ioboard_poll_commands[0]))
+
+static spi_transaction_t ioboard_poll_txn;
+static uint8_t ioboard_poll_frame[1 + IOBOARD_MAX_DATA];   // Command, then the reply
+static uint8_t ioboard_poll_command;                        // Command in flight
+static uint8_t ioboard_poll_index;
+static ioboard_state_t ioboard_state;                       // Written from the SPI interrupt
+
+// Bytes the board answers with for a command
+static uint8_t ioboard_reply_length(uint8_t command) {
+    return command == IOBOARD_CMD_TOUCHSLIDER ? 2 : 3;
+}
+
+// SPI interrupt: move the reply into the cache
+static void ioboard_poll_done(spi_transaction_t* t) {
+    (void)t;
+    const uint8_t* data = &ioboard_poll_frame[1];
+    switch (ioboard_poll_command) {
+        case IOBOARD_CMD_BUTTONS:
+            ioboard_state.buttons = (ioboard_buttons_t){ data[0], data[1], data[2] };
+            break;
+        case IOBOARD_CMD_TOUCHPAD:
+            ioboard_state.touchpad = (ioboard_touchpad_t){ data[0], data[1], data[2] };
+            break;
+        case IOBOARD_CMD_TOUCHSLIDER:
+            ioboard_state.touchslider = (ioboard_touchslider_t){ data[0], data[1] };
+            break;
+    }
+    ioboard_state.updates++;
+}
+
+// LED commands are queued from a static frame so the caller does not wait for the bus
+static spi_transaction_t ioboard_led_txn;
+static uint8_t ioboard_led_frame[3];
+
+static void ioboard_led_send(uint8_t command, uint8_t led_num, uint8_t value) {
+    spi_wait(&ioboard_led_txn);    // Previous LED command still owns the frame
+    ioboard_led_frame[0] = command;
+    ioboard_led_frame[1] = led_num;
+    ioboard_led_frame[2] = value;
+    ioboard_led_txn = (spi_transaction_t){
+        .device = &ioboard_spi,
+        .tx = ioboard_led_frame,
+        .tx_len = sizeof(ioboard_led_frame),
+        .len = sizeof(ioboard_led_frame),
+    };
+    if (!spi_submit(&ioboard_led_txn)) {
+        // Queue full: fall back to waiting for room
+        while (!spi_submit(&ioboard_led_txn))
+            ;
     }
 }
 
 // === Public Functions ===
 
 void ioboard_init(void) {
-    // I/O board uses the same SPI as OLED, so SPI should already be initialized
-    // Just ensure SPI is in master mode
-    SPI_MasterInit();
+    // Register with the SPI bus (PB4 as output, deselected)
+    spi_device_init(&ioboard_spi);
     
-    // Initialize I/O board chip select pin (PB4)
-    DDRB |= (1 << PB4);    // Set PB4 as output
-    PORTB |= (1 << PB4);   // Set PB4 high (deselected)
+    ioboard_state = (ioboard_state_t){0};
+    ioboard_poll_index = 0;
 }
 
-uint8_t ioboard_spi_command(uint8_t command, uint8_t* data_buffer, uint8_t data_length) {
-    // Select I/O board using IO_CS pin (PB4/SPI_SS) - NOT the OLED CS pin
-    PORTB &= ~(1 << PB4);  // Pull IO_CS (PB4) low to select I/O board
-    
-    // Send command byte
-    SPI_Transfer(command);
+void ioboard_service(void) {
+    if (ioboard_poll_txn.busy) return;     // Previous read still on the bus
     
-    // Wait required delay between command and first data byte (40µs minimum)
-    ioboard_delay_us(IOBOARD_CMD_DATA_DELAY_US);
+    uint8_t command = ioboard_poll_commands[ioboard_poll_index];
+    ioboard_poll_command = command;
+    ioboard_poll_frame[0] = command;
+    ioboard_poll_txn = (spi_transaction_t){
+        .device = &ioboard_spi,
+        .tx = ioboard_poll_frame,
+        .tx_len = 1,
+        .rx = ioboard_poll_frame,         // Reply overwrites the command, data from [1]
+        .len = 1 + ioboard_reply_length(command),
+        .done = ioboard_poll_done,
+    };
+    if (!spi_submit(&ioboard_poll_txn)) return;   // Bus queue full, try again next call
     
-    // Read data bytes with required delays
-    for (uint8_t i = 0; i < data_length; i++) {
-        if (i > 0) {
-            // Wait required delay between data bytes (2µs minimum)
-            ioboard_delay_us(IOBOARD_DATA_DELAY_US);
-        }
-        data_buffer[i] = SPI_Transfer(0x00);  // Send dummy byte to read
-    }
+    ioboard_poll_index = (ioboard_poll_index + 1) % IOBOARD_POLL_COUNT;
+}
+
+void ioboard_get_state(ioboard_state_t* state) {
+    uint8_t sreg = SREG;
+    cli();
+    *state = ioboard_state;
+    SREG = sreg;
+}
+
+ioboard_buttons_t ioboard_get_buttons(void) {
+    ioboard_state_t state;
+    ioboard_get_state(&state);
+    return state.buttons;
+}
+
+uint8_t ioboard_spi_command(uint8_t command, uint8_t* data_buffer, uint8_t data_length) {
+    uint8_t frame[1 + IOBOARD_MAX_DATA] = { command };
+    if (data_length > IOBOARD_MAX_DATA) data_length = IOBOARD_MAX_DATA;
     
-    // Deselect I/O board
-    PORTB |= (1 << PB4);   // Pull IO_CS (PB4) high to deselect I/O board
+    // Command byte first, then dummy bytes while the board answers
+    ioboard_transfer(frame, 1, frame, 1 + data_length);
+    memcpy(data_buffer, &frame[1], data_length);
     
     return data_length;
 }
@@ -75,33 +165,13 @@ ioboard_buttons_t ioboard_read_buttons(void) {
 // Info function removed to save RAM
 
 void ioboard_led_set(uint8_t led_num, bool on_off) {
-    uint8_t data[2];
-    data[0] = led_num;
-    data[1] = on_off ? 1 : 0;
-    
     // For LED commands, we send data instead of reading
-    SPI_Select();
-    SPI_Transfer(IOBOARD_CMD_LED_ONOFF);
-    ioboard_delay_us(IOBOARD_CMD_DATA_DELAY_US);
-    SPI_Transfer(data[0]);
-    ioboard_delay_us(IOBOARD_DATA_DELAY_US);
-    SPI_Transfer(data[1]);
-    SPI_Deselect();
+    ioboard_led_send(IOBOARD_CMD_LED_ONOFF, led_num, on_off ? 1 : 0);
 }
 
 void ioboard_led_pwm(uint8_t led_num, uint8_t brightness) {
-    uint8_t data[2];
-    data[0] = led_num;
-    data[1] = brightness;  // 0-255 for PWM width
-    
-    // For LED PWM commands, we send data instead of reading
-    SPI_Select();
-    SPI_Transfer(IOBOARD_CMD_LED_PWM);
-    ioboard_delay_us(IOBOARD_CMD_DATA_DELAY_US);
-    SPI_Transfer(data[0]);
-    ioboard_delay_us(IOBOARD_DATA_DELAY_US);
-    SPI_Transfer(data[1]);
-    SPI_Deselect();
+    // For LED PWM commands, we send data instead of reading (0-255 PWM width)
+    ioboard_led_send(IOBOARD_CMD_LED_PWM, led_num, brightness);
 }
 
 void btn_test(void){
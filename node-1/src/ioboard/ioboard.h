@@ -21,6 +21,18 @@
 // SPI timing constraints (from documentation)
 #define IOBOARD_CMD_DATA_DELAY_US   40  // 40µs minimum between command and first data
 #define IOBOARD_DATA_DELAY_US       2   // 2µs minimum between data bytes
+#define IOBOARD_MAX_DATA            3   // Longest reply (touchpad, joystick, buttons)
+
+// Background polling: one read every IOBOARD_POLL_MS, rotating through buttons,
+// touchpad and touch slider (each refreshed every 3 * IOBOARD_POLL_MS)
+#define IOBOARD_POLL_MS             5
+
+// Bits of ioboard_buttons_t.nav
+#define IOBOARD_NAV_UP              (1 << 0)
+#define IOBOARD_NAV_DOWN            (1 << 1)
+#define IOBOARD_NAV_LEFT            (1 << 2)
+#define IOBOARD_NAV_RIGHT           (1 << 3)
+#define IOBOARD_NAV_BTN             (1 << 4)
 
 // Data structures for I/O board responses
 // NOTE: Joystick center button (JOY_B) is directly connected to ATmega162 PB1
@@ -51,16 +63,32 @@ typedef struct {
 
 // Info struct removed to save RAM - use individual reads if needed
 
+// Latest readings from the background poll
+typedef struct {
+    ioboard_buttons_t buttons;
+    ioboard_touchpad_t touchpad;
+    ioboard_touchslider_t touchslider;
+    uint16_t updates;   // Incremented with every completed read
+} ioboard_state_t;
+
 // === I/O Board Functions ===
 
 // Initialize I/O board communication
 void ioboard_init(void);
 
-// Read functions - minimal set
+// Background polling: register as a scheduler task every IOBOARD_POLL_MS. Queues
+// the next read and returns immediately (the SPI interrupt clocks it and fills the cache)
+void ioboard_service(void);
+
+// Cached readings (no SPI traffic); all zero until the first poll completes
+void ioboard_get_state(ioboard_state_t* state);
+ioboard_buttons_t ioboard_get_buttons(void);
+
+// Blocking read functions - minimal set
 ioboard_buttons_t ioboard_read_buttons(void);
 ioboard_joystick_t ioboard_read_joystick(void);
 
-// LED control functions
+// LED control functions (queued, only wait if the previous LED command is still pending)
 void ioboard_led_set(uint8_t led_num, bool on_off);
 void ioboard_led_pwm(uint8_t led_num, uint8_t brightness);
 
@@ -1,6 +1,8 @@
 #include "joystick.h"
 #include "adc/adc.h"
 #include "oled/oled.h"
+#include "xmem/xmem.h"
+#include "cal_store/cal_store.h"
 #include <stdbool.h>
 #include <avr/io.h>
 #include <avr/pgmspace.h>
@@ -10,6 +12,7 @@
 static struct {
     uint16_t x_min, x_max;
     uint16_t y_min, y_max;
+    uint16_t x_mid, y_mid;  // Resting position (first calibration sample)
     bool initialized;
 } joystick_cal = {0};
 
@@ -20,46 +23,169 @@ static struct {
     bool initialized;
 } slider_cal = {0};
 
-// Auto-calibration functions
-static void joystick_auto_calibrate(uint16_t adc_x, uint16_t adc_y)
+// Both calibrations as stored in EEPROM (ADC values are 8 bit)
+typedef struct {
+    uint8_t joystick_valid;
+    uint8_t joy_x_min, joy_x_mid, joy_x_max;
+    uint8_t joy_y_min, joy_y_mid, joy_y_max;
+    uint8_t slider_valid;
+    uint8_t slider_x_min, slider_x_max;
+    uint8_t slider_y_min, slider_y_max;
+} joystick_cal_record_t;
+
+// Mapping tables in external SRAM, indexed by raw ADC value
+enum {
+    JOYSTICK_LUT_X,
+    JOYSTICK_LUT_Y,
+    SLIDER_LUT_X,
+    SLIDER_LUT_Y
+};
+static uint8_t (*joystick_lut)[JOYSTICK_LUT_SIZE];
+static joystick_curve_t joystick_curve = JOYSTICK_CURVE_LINEAR;
+static bool joystick_lut_ready = false;
+
+// Auto-calibration functions, return true if a bound moved
+static bool joystick_auto_calibrate(uint16_t adc_x, uint16_t adc_y)
 {
     if (!joystick_cal.initialized) {
-        // First reading - initialize with current values
-        joystick_cal.x_min = joystick_cal.x_max = adc_x;
-        joystick_cal.y_min = joystick_cal.y_max = adc_y;
+        // First reading - initialize with current values, the stick is resting
+        joystick_cal.x_min = joystick_cal.x_max = joystick_cal.x_mid = adc_x;
+        joystick_cal.y_min = joystick_cal.y_max = joystick_cal.y_mid = adc_y;
         joystick_cal.initialized = true;
-    } else {
-        // Update min/max values
-        if (adc_x < joystick_cal.x_min) joystick_cal.x_min = adc_x;
-        if (adc_x > joystick_cal.x_max) joystick_cal.x_max = adc_x;
-        if (adc_y < joystick_cal.y_min) joystick_cal.y_min = adc_y;
-        if (adc_y > joystick_cal.y_max) joystick_cal.y_max = adc_y; 
+        return true;
+    }
+    
+    // Update min/max values
+    bool changed = false;
+    if (adc_x < joystick_cal.x_min) { joystick_cal.x_min = adc_x; changed = true; }
+    if (adc_x > joystick_cal.x_max) { joystick_cal.x_max = adc_x; changed = true; }
+    if (adc_y < joystick_cal.y_min) { joystick_cal.y_min = adc_y; changed = true; }
+    if (adc_y > joystick_cal.y_max) { joystick_cal.y_max = adc_y; changed = true; }
+    return changed;
+}
+
+// Deflection 0-50 from centre after the response curve (16-bit math only)
+static uint8_t joystick_apply_curve(uint8_t deflection)
+{
+    switch (joystick_curve) {
+        case JOYSTICK_CURVE_SOFT:
+            return (uint16_t)deflection * deflection / 50;
+        case JOYSTICK_CURVE_SHARP:
+            return 2 * deflection - (uint16_t)deflection * deflection / 50;
+        default:
+            return deflection;
     }
 }
 
-// Helper functions
-static uint8_t normalize_to_percentage(uint16_t adc_value, uint16_t min_val, uint16_t max_val)
+// Deflection 0-50 after deadzone and response curve, for every raw deflection 0-50.
+// Shared by both axes so a rebuild divides ~100 times instead of per table entry.
+#define JOYSTICK_SHAPE_SIZE     51
+static void joystick_build_shape(uint8_t *shape)
 {
-    // Clamp to valid range
-    if (adc_value <= min_val) return 0;
-    if (adc_value >= max_val) return 100;
+    for (uint8_t deflection = 0; deflection < JOYSTICK_SHAPE_SIZE; deflection++) {
+        // Deadzone, then stretch the rest back over the full 0-50
+        uint8_t d = deflection <= JOYSTICK_DEADZONE ? 0
+                  : (uint16_t)(deflection - JOYSTICK_DEADZONE) * 50 / (50 - JOYSTICK_DEADZONE);
+        shape[deflection] = joystick_apply_curve(d);
+    }
+}
+
+// Advance quotient/remainder of dist * scale / span by one dist, without dividing.
+// Keeps *q == dist * scale / span exactly; the inner loop runs scale times in total.
+static inline void lut_step(uint8_t *q, uint16_t *r, uint8_t scale, uint16_t span)
+{
+    *r += scale;
+    while (*r >= span) {
+        *r -= span;
+        (*q)++;
+    }
+}
+
+// One joystick axis: [min, mid] -> [0, 50], [mid, max] -> [50, 100], deadzone around mid.
+// Called on every moved bound while calibrating, so the per-entry scaling is incremental.
+static void joystick_build_axis(uint8_t *lut, const uint8_t *shape,
+                                uint16_t min_val, uint16_t mid_val, uint16_t max_val)
+{
+    // Centre outside the range (no resting sample yet), fall back to the midpoint
+    if (mid_val <= min_val || mid_val >= max_val) {
+        mid_val = (min_val + max_val) / 2;
+    }
     
-    // Linear scaling from [min_val, max_val] to [0, 100]
-    uint32_t result = ((uint32_t)(adc_value - min_val) * 100) / (max_val - min_val);
+    // Below the centre, walking down from mid: deflection = dist * 50 / (mid - min)
+    uint16_t span = mid_val - min_val;
+    uint8_t q = 0;
+    uint16_t r = 0;
+    for (uint16_t dist = 1; dist <= mid_val; dist++) {
+        if (dist <= span) lut_step(&q, &r, 50, span);   // Past min it stays at 50
+        lut[mid_val - dist] = 50 - shape[q];
+    }
     
-    return (uint8_t)result;
+    // Centre and above: deflection = (adc - mid) * 50 / (max - mid)
+    span = max_val - mid_val;
+    q = 0;
+    r = 0;
+    lut[mid_val] = 50 + shape[0];
+    for (uint16_t adc = mid_val + 1; adc < JOYSTICK_LUT_SIZE; adc++) {
+        if (adc <= max_val) lut_step(&q, &r, 50, span);
+        lut[adc] = 50 + shape[q];
+    }
 }
 
-static uint8_t normalize_to_byte(uint16_t adc_value, uint16_t min_val, uint16_t max_val)
+// One slider axis: [min, max] -> [0, 255]
+static void slider_build_axis(uint8_t *lut, uint16_t min_val, uint16_t max_val)
 {
-    // Clamp to valid range
-    if (adc_value <= min_val) return 0;
-    if (adc_value >= max_val) return 255;
-    
-    // Linear scaling from [min_val, max_val] to [0, 255]
-    uint32_t result = ((uint32_t)(adc_value - min_val) * 255) / (max_val - min_val);
+    uint16_t span = max_val - min_val;
+    uint8_t q = 0;
+    uint16_t r = 0;
+    for (uint16_t adc = 0; adc < JOYSTICK_LUT_SIZE; adc++) {
+        if (adc <= min_val) {
+            lut[adc] = 0;
+        } else if (adc >= max_val) {
+            lut[adc] = 255;
+        } else {
+            lut_step(&q, &r, 255, span);    // q == (adc - min) * 255 / span
+            lut[adc] = q;
+        }
+    }
+}
+
+static void joystick_build_lut(void)
+{
+    uint8_t shape[JOYSTICK_SHAPE_SIZE];
+    joystick_build_shape(shape);
     
-    return (uint8_t)result;
+    if (joystick_cal.initialized) {
+        joystick_build_axis(joystick_lut[JOYSTICK_LUT_X], shape, joystick_cal.x_min, joystick_cal.x_mid, joystick_cal.x_max);
+        joystick_build_axis(joystick_lut[JOYSTICK_LUT_Y], shape, joystick_cal.y_min, joystick_cal.y_mid, joystick_cal.y_max);
+    } else {
+        joystick_build_axis(joystick_lut[JOYSTICK_LUT_X], shape, JOYSTICK_ADC_X_MIN, 0, JOYSTICK_ADC_X_MAX);
+        joystick_build_axis(joystick_lut[JOYSTICK_LUT_Y], shape, JOYSTICK_ADC_Y_MIN, 0, JOYSTICK_ADC_Y_MAX);
+    }
+}
+
+static void slider_build_lut(void)
+{
+    if (slider_cal.initialized) {
+        slider_build_axis(joystick_lut[SLIDER_LUT_X], slider_cal.x_min, slider_cal.x_max);
+        slider_build_axis(joystick_lut[SLIDER_LUT_Y], slider_cal.y_min, slider_cal.y_max);
+    } else {
+        slider_build_axis(joystick_lut[SLIDER_LUT_X], SLIDER_ADC_X_MIN, SLIDER_ADC_X_MAX);
+        slider_build_axis(joystick_lut[SLIDER_LUT_Y], SLIDER_ADC_Y_MIN, SLIDER_ADC_Y_MAX);
+    }
+}
+
+// Tables live in external SRAM, so build them on first use if joystick_init was skipped.
+// Returns true if all tables were just built.
+static bool joystick_lut_ensure(void)
+{
+    if (joystick_lut_ready) return false;
+    if (joystick_lut == NULL) {
+        joystick_lut = xmem_arena_alloc_or_halt(JOYSTICK_LUT_COUNT * JOYSTICK_LUT_SIZE, PSTR("Joystick"));
+    }
+    joystick_build_lut();
+    slider_build_lut();
+    joystick_lut_ready = true;
+    return true;
 }
 
 void joystick_init(void)
@@ -69,6 +195,57 @@ void joystick_init(void)
     // All other buttons (touchpad, slider, etc.) come via SPI from I/O board
     JOYSTICK_BUTTON_DDR &= ~(1 << JOYSTICK_BUTTON_PIN);  // Set as input
     JOYSTICK_BUTTON_PORT |= (1 << JOYSTICK_BUTTON_PIN);  // Enable pull-up
+    
+    // Last saved calibration, if any, so no round starts with the default scaling
+    joystick_cal_record_t record;
+    if (cal_store_load(&record, sizeof(record))) {
+        if (record.joystick_valid) {
+            joystick_cal.x_min = record.joy_x_min;
+            joystick_cal.x_mid = record.joy_x_mid;
+            joystick_cal.x_max = record.joy_x_max;
+            joystick_cal.y_min = record.joy_y_min;
+            joystick_cal.y_mid = record.joy_y_mid;
+            joystick_cal.y_max = record.joy_y_max;
+            joystick_cal.initialized = true;
+        }
+        if (record.slider_valid) {
+            slider_cal.x_min = record.slider_x_min;
+            slider_cal.x_max = record.slider_x_max;
+            slider_cal.y_min = record.slider_y_min;
+            slider_cal.y_max = record.slider_y_max;
+            slider_cal.initialized = true;
+        }
+        printf_P(PSTR("Calibration loaded from EEPROM\r\n"));
+    }
+    
+    joystick_lut_ready = false;
+    joystick_lut_ensure();      // Stored or default calibration until joystick_calibrate_now
+}
+
+void joystick_save_calibration(void)
+{
+    joystick_cal_record_t record = {
+        .joystick_valid = joystick_cal.initialized,
+        .joy_x_min = joystick_cal.x_min,
+        .joy_x_mid = joystick_cal.x_mid,
+        .joy_x_max = joystick_cal.x_max,
+        .joy_y_min = joystick_cal.y_min,
+        .joy_y_mid = joystick_cal.y_mid,
+        .joy_y_max = joystick_cal.y_max,
+        .slider_valid = slider_cal.initialized,
+        .slider_x_min = slider_cal.x_min,
+        .slider_x_max = slider_cal.x_max,
+        .slider_y_min = slider_cal.y_min,
+        .slider_y_max = slider_cal.y_max,
+    };
+    cal_store_save(&record, sizeof(record));
+}
+
+void joystick_set_curve(joystick_curve_t curve)
+{
+    if (curve >= JOYSTICK_CURVE_COUNT) return;
+    joystick_curve = curve;
+    if (!joystick_lut_ensure()) joystick_build_lut();
 }
 
 static uint8_t joystick_read_button(void)
@@ -79,24 +256,14 @@ static uint8_t joystick_read_button(void)
     return !(JOYSTICK_BUTTON_PINREG & (1 << JOYSTICK_BUTTON_PIN));
 }
 
-joystick_pos_t joystick_get_position(void)
+// Joystick axes from one ADC snapshot: one table lookup per axis
+static joystick_pos_t joystick_from_adc(const uint8_t adc[ADC_CHANNELS])
 {
     joystick_pos_t pos;
     
-    // Read ADC values
-    uint16_t adc_x = adc_read(JOYSTICK_ADC_X_CHANNEL);  // A1
-    uint16_t adc_y = adc_read(JOYSTICK_ADC_Y_CHANNEL);  // A0
-    
-    // NO auto-calibration - only use fixed defaults or explicit calibration
-    // Use calibrated values if available, otherwise use fixed defaults
-    uint16_t x_min = joystick_cal.initialized ? joystick_cal.x_min : JOYSTICK_ADC_X_MIN;
-    uint16_t x_max = joystick_cal.initialized ? joystick_cal.x_max : JOYSTICK_ADC_X_MAX;
-    uint16_t y_min = joystick_cal.initialized ? joystick_cal.y_min : JOYSTICK_ADC_Y_MIN;
-    uint16_t y_max = joystick_cal.initialized ? joystick_cal.y_max : JOYSTICK_ADC_Y_MAX;
-    
-    // Normalize to 0 to 100% range using calibrated values
-    pos.x = normalize_to_percentage(adc_x, x_min, x_max);
-    pos.y = normalize_to_percentage(adc_y, y_min, y_max);
+    // Calibration, centre trim, deadzone and response curve are all in the tables
+    pos.x = joystick_lut[JOYSTICK_LUT_X][adc[JOYSTICK_ADC_X_CHANNEL]];  // A1
+    pos.y = joystick_lut[JOYSTICK_LUT_Y][adc[JOYSTICK_ADC_Y_CHANNEL]];  // A0
     
     // Read joystick center button (JOY_B) from PB1 (active low with pull-up)
     // Note: Other buttons (touchpad, slider) are accessed via SPI through I/O board
@@ -105,31 +272,47 @@ joystick_pos_t joystick_get_position(void)
     return pos;
 }
 
-slider_pos_t slider_get_position(void)
+// Slider axes from one ADC snapshot
+static slider_pos_t slider_from_adc(const uint8_t adc[ADC_CHANNELS])
 {
     slider_pos_t pos;
     
-    // Read ADC values
-    uint16_t adc_x = adc_read(SLIDER_ADC_X_CHANNEL);  // A2
-    uint16_t adc_y = adc_read(SLIDER_ADC_Y_CHANNEL);  // A3
-    
-    // Use calibrated values if available, otherwise use fixed defaults
-    uint16_t x_min = slider_cal.initialized ? slider_cal.x_min : SLIDER_ADC_X_MIN;
-    uint16_t x_max = slider_cal.initialized ? slider_cal.x_max : SLIDER_ADC_X_MAX;
-    uint16_t y_min = slider_cal.initialized ? slider_cal.y_min : SLIDER_ADC_Y_MIN;
-    uint16_t y_max = slider_cal.initialized ? slider_cal.y_max : SLIDER_ADC_Y_MAX;
-    
-    // Normalize to 0-255 range using calibrated or default values
-    pos.x = normalize_to_byte(adc_x, x_min, x_max);
-    pos.y = normalize_to_byte(adc_y, y_min, y_max);
+    pos.x = joystick_lut[SLIDER_LUT_X][adc[SLIDER_ADC_X_CHANNEL]];  // A2
+    pos.y = joystick_lut[SLIDER_LUT_Y][adc[SLIDER_ADC_Y_CHANNEL]];  // A3
     
     return pos;
 }
 
+joystick_pos_t joystick_get_position(void)
+{
+    joystick_lut_ensure();
+    uint8_t adc[ADC_CHANNELS];
+    adc_read_all(adc);
+    return joystick_from_adc(adc);
+}
+
+slider_pos_t slider_get_position(void)
+{
+    joystick_lut_ensure();
+    uint8_t adc[ADC_CHANNELS];
+    adc_read_all(adc);
+    return slider_from_adc(adc);
+}
+
+void joystick_read_inputs(joystick_pos_t *joy, slider_pos_t *slider)
+{
+    joystick_lut_ensure();
+    uint8_t adc[ADC_CHANNELS];
+    adc_read_all(adc);
+    *joy = joystick_from_adc(adc);
+    *slider = slider_from_adc(adc);
+}
+
 // Calibration management functions
 void joystick_reset_calibration(void)
 {
     joystick_cal.initialized = false;
+    if (!joystick_lut_ensure()) joystick_build_lut();
 }
 
 void joystick_get_calibration(uint16_t *x_min, uint16_t *x_max, uint16_t *y_min, uint16_t *y_max)
@@ -148,56 +331,65 @@ void joystick_get_calibration(uint16_t *x_min, uint16_t *x_max, uint16_t *y_min,
     }
 }
 
-// Slider auto-calibration functions
-static void slider_auto_calibrate(uint16_t adc_x, uint16_t adc_y)
+// Slider auto-calibration functions, return true if a bound moved
+static bool slider_auto_calibrate(uint16_t adc_x, uint16_t adc_y)
 {
     if (!slider_cal.initialized) {
         // First reading - initialize with current values
         slider_cal.x_min = slider_cal.x_max = adc_x;
         slider_cal.y_min = slider_cal.y_max = adc_y;
         slider_cal.initialized = true;
-    } else {
-        // Update min/max values
-        if (adc_x < slider_cal.x_min) slider_cal.x_min = adc_x;
-        if (adc_x > slider_cal.x_max) slider_cal.x_max = adc_x;
-        if (adc_y < slider_cal.y_min) slider_cal.y_min = adc_y;
-        if (adc_y > slider_cal.y_max) slider_cal.y_max = adc_y; 
+        return true;
     }
+    
+    // Update min/max values
+    bool changed = false;
+    if (adc_x < slider_cal.x_min) { slider_cal.x_min = adc_x; changed = true; }
+    if (adc_x > slider_cal.x_max) { slider_cal.x_max = adc_x; changed = true; }
+    if (adc_y < slider_cal.y_min) { slider_cal.y_min = adc_y; changed = true; }
+    if (adc_y > slider_cal.y_max) { slider_cal.y_max = adc_y; changed = true; }
+    return changed;
 }
 
 // Explicit calibration function - call this to calibrate joystick manually
 void joystick_calibrate_now(void)
 {
     // Read current ADC values and use for calibration
-    uint16_t adc_x = adc_read(JOYSTICK_ADC_X_CHANNEL);  
-    uint16_t adc_y = adc_read(JOYSTICK_ADC_Y_CHANNEL);  
+    uint8_t adc[ADC_CHANNELS];
+    adc_read_all(adc);
     
-    // Force calibration with current reading
-    joystick_auto_calibrate(adc_x, adc_y);
+    // Force calibration with current reading, rebuild the tables only if a bound moved
+    if (joystick_auto_calibrate(adc[JOYSTICK_ADC_X_CHANNEL], adc[JOYSTICK_ADC_Y_CHANNEL])) {
+        if (!joystick_lut_ensure()) joystick_build_lut();
+    }
 }
 
 // Explicit calibration function - call this to calibrate slider manually
 void slider_calibrate_now(void)
 {
     // Read current ADC values and use for calibration
-    uint16_t adc_x = adc_read(SLIDER_ADC_X_CHANNEL);  
-    uint16_t adc_y = adc_read(SLIDER_ADC_Y_CHANNEL);  
+    uint8_t adc[ADC_CHANNELS];
+    adc_read_all(adc);
     
-    // Force calibration with current reading
-    slider_auto_calibrate(adc_x, adc_y);
+    // Force calibration with current reading, rebuild the tables only if a bound moved
+    if (slider_auto_calibrate(adc[SLIDER_ADC_X_CHANNEL], adc[SLIDER_ADC_Y_CHANNEL])) {
+        if (!joystick_lut_ensure()) slider_build_lut();
+    }
 }
 
 // Reset slider calibration
 void slider_reset_calibration(void)
 {
     slider_cal.initialized = false;
+    if (!joystick_lut_ensure()) slider_build_lut();
 }
 
 void display_joystick(void) {
 
     // Get joystick and slider positions
-    joystick_pos_t joy_pos = joystick_get_position();
-    slider_pos_t slider_pos = slider_get_position();
+    joystick_pos_t joy_pos;
+    slider_pos_t slider_pos;
+    joystick_read_inputs(&joy_pos, &slider_pos);
     
     // Create strings for OLED display
     char joy_str[20], slider_str[20];
@@ -209,11 +401,9 @@ void display_joystick(void) {
     oled_print_string("Input Test", 0, 0);
     oled_print_string(joy_str, 0, 2);
     oled_print_string(slider_str, 0, 3);
+    oled_flush();
     
     // Also send to serial for debugging  
     printf_P(PSTR("Joystick: X=%u%%, Y=%u%% | Slider: X=%u, Y=%u\r\n"), 
            joy_pos.x, joy_pos.y, slider_pos.x, slider_pos.y);
-    
-    _delay_ms(100);  // Update every 100ms
-    
 }
@@ -26,6 +26,22 @@
 #define SLIDER_ADC_Y_MIN        0       // Minimum ADC value for slider Y  
 #define SLIDER_ADC_Y_MAX        255     // Maximum ADC value for slider Y
 
+// Mapping tables (ADC value -> output), 256 bytes per axis in external SRAM (xmem
+// arena). Rebuilt whenever the calibration or curve changes.
+#define JOYSTICK_LUT_SIZE       256
+#define JOYSTICK_LUT_COUNT      4       // Joystick X/Y, slider X/Y
+
+// Joystick deflection (in % from centre) that still reads as centre (50%)
+#define JOYSTICK_DEADZONE       3
+
+// Response curve of the joystick axes (the slider is always linear)
+typedef enum {
+    JOYSTICK_CURVE_LINEAR,      // Medium
+    JOYSTICK_CURVE_SOFT,        // Easy: quadratic, fine control near the centre
+    JOYSTICK_CURVE_SHARP,       // Hard: reaches large deflections quickly
+    JOYSTICK_CURVE_COUNT
+} joystick_curve_t;
+
 // Position structures
 typedef struct {
     uint8_t x;          // X position (0 to 100%)
@@ -39,7 +55,7 @@ typedef struct {
 } slider_pos_t;
 
 /**
- * Initialize joystick (including button pin setup)
+ * Initialize joystick (including button pin setup) and load the stored calibration
  */
 void joystick_init(void);
 
@@ -53,6 +69,11 @@ joystick_pos_t joystick_get_position(void);
  */
 slider_pos_t slider_get_position(void);
 
+/**
+ * Joystick and slider from a single ADC conversion
+ */
+void joystick_read_inputs(joystick_pos_t *joy, slider_pos_t *slider);
+
 /**
  * Reset joystick auto-calibration (forces recalibration)
  */
@@ -69,7 +90,19 @@ void joystick_get_calibration(uint16_t *x_min, uint16_t *x_max, uint16_t *y_min,
 void joystick_calibrate_now(void);
 
 /**
- * Display joystick and slider values on OLED (for testing)
+ * Store the current joystick and slider calibration in EEPROM
+ * (joystick_init loads it again after a reset). Written in the background by a
+ * scheduler task, see cal_store_save.
+ */
+void joystick_save_calibration(void);
+
+/**
+ * Select the joystick response curve (rebuilds the mapping tables)
+ */
+void joystick_set_curve(joystick_curve_t curve);
+
+/**
+ * Display joystick and slider values on OLED (for testing), once per call
  */
 void display_joystick(void);
 
@@ -0,0 +1,98 @@
+#include "joystick_tx.h"
+#include "can/can.h"
+#include "cpu_time/cpu_time.h"
+#include "protocol.h"
+
+// Last sample that went out on the bus, changes are measured against it
+static struct {
+    joystick_pos_t joy;
+    slider_pos_t slider;
+    uint32_t last_tx_ms;
+    uint32_t last_update_ms;
+    uint8_t primed;         // 0 until the first frame is sent
+} joystick_tx;
+
+static joystick_tx_stats_t joystick_tx_counters[JOYSTICK_TX_STATES];
+
+static uint8_t joystick_tx_differs(uint8_t a, uint8_t b, uint8_t deadband)
+{
+    return (a > b ? a - b : b - a) > deadband;
+}
+
+static uint8_t joystick_tx_moved(joystick_pos_t joy, slider_pos_t slider)
+{
+    return joy.button != joystick_tx.joy.button
+        || joystick_tx_differs(joy.x, joystick_tx.joy.x, JOYSTICK_TX_DEADBAND)
+        || joystick_tx_differs(joy.y, joystick_tx.joy.y, JOYSTICK_TX_DEADBAND)
+        || joystick_tx_differs(slider.x, joystick_tx.slider.x, JOYSTICK_TX_SLIDER_DEADBAND)
+        || joystick_tx_differs(slider.y, joystick_tx.slider.y, JOYSTICK_TX_SLIDER_DEADBAND);
+}
+
+void joystick_tx_init(void)
+{
+    joystick_tx.primed = 0;
+    joystick_tx.last_update_ms = (uint32_t)cpu_time_milliseconds();
+    joystick_tx_stats_reset();
+}
+
+uint8_t joystick_tx_update(joystick_pos_t joy, slider_pos_t slider, uint8_t state)
+{
+    if (state >= JOYSTICK_TX_STATES) {
+        state = JOYSTICK_TX_STATES - 1;
+    }
+    joystick_tx_stats_t* counters = &joystick_tx_counters[state];
+
+    uint32_t now = (uint32_t)cpu_time_milliseconds();
+    counters->time_ms += now - joystick_tx.last_update_ms;
+    joystick_tx.last_update_ms = now;
+
+    uint32_t since_tx = now - joystick_tx.last_tx_ms;
+    uint8_t moved = !joystick_tx.primed || joystick_tx_moved(joy, slider);
+
+    if (moved && since_tx < JOYSTICK_TX_MIN_INTERVAL_MS) {
+        // Still compared against the last sent sample, so it goes out next time
+        counters->suppressed++;
+        return 0;
+    }
+    if (!moved && since_tx < JOYSTICK_TX_HEARTBEAT_MS) {
+        return 0;
+    }
+
+    can_message_t msg = {
+        PROTO_MSG(PROTO_ID_JOYSTICK, proto_joystick_t,
+            .x = joy.x,
+            .y = joy.y,
+            .button = joy.button,
+            .slider_x = slider.x,
+            .slider_y = slider.y)
+    };
+    if (!can_send_message_priority(&msg, CAN_PRIO_CONTROL)) {
+        counters->failed++;
+        return 0;
+    }
+
+    if (moved) {
+        counters->changes++;
+    } else {
+        counters->heartbeats++;
+    }
+    joystick_tx.joy = joy;
+    joystick_tx.slider = slider;
+    joystick_tx.last_tx_ms = now;
+    joystick_tx.primed = 1;
+    return 1;
+}
+
+void joystick_tx_stats(uint8_t state, joystick_tx_stats_t* stats)
+{
+    if (state < JOYSTICK_TX_STATES) {
+        *stats = joystick_tx_counters[state];
+    }
+}
+
+void joystick_tx_stats_reset(void)
+{
+    for (uint8_t i = 0; i < JOYSTICK_TX_STATES; i++) {
+        joystick_tx_counters[i] = (joystick_tx_stats_t){0};
+    }
+}
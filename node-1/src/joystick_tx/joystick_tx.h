@@ -0,0 +1,62 @@
+#ifndef JOYSTICK_TX_H
+#define JOYSTICK_TX_H
+
+#include <stdint.h>
+#include "joystick/joystick.h"
+
+/*
+ * Change-driven joystick sender.
+ *
+ * A frame goes out as soon as the input moves past the deadband (at most
+ * every JOYSTICK_TX_MIN_INTERVAL_MS, i.e. 200 Hz while the stick is moving)
+ * and otherwise only as a heartbeat every JOYSTICK_TX_HEARTBEAT_MS, so Node 2
+ * can still tell that Node 1 is alive.
+ */
+
+// Joystick axis change (in %) that counts as movement
+#define JOYSTICK_TX_DEADBAND            2
+
+// Slider change (0-255) that counts as movement
+#define JOYSTICK_TX_SLIDER_DEADBAND     4
+
+// Shortest gap between two frames (5 ms = 200 Hz)
+#define JOYSTICK_TX_MIN_INTERVAL_MS     5
+
+// Frame rate while nothing changes
+#define JOYSTICK_TX_HEARTBEAT_MS        250
+
+// Number of caller states the counters are kept for (e.g. menu screens)
+#define JOYSTICK_TX_STATES              4
+
+typedef struct {
+    uint16_t changes;       // Frames sent because the input moved
+    uint16_t heartbeats;    // Frames sent because the heartbeat ran out
+    uint16_t suppressed;    // Changes held back by the rate limit
+    uint16_t failed;        // Frames the CAN TX queue refused
+    uint32_t time_ms;       // Time spent in this state
+} joystick_tx_stats_t;
+
+/**
+ * Reset the sender; the first update always transmits.
+ * Needs cpu_time_init() and the CAN driver to be set up.
+ */
+void joystick_tx_init(void);
+
+/**
+ * Send the sample if it moved past the deadband or the heartbeat is due.
+ * `state` (< JOYSTICK_TX_STATES) only selects which counters are updated.
+ * Returns 1 if a frame was queued.
+ */
+uint8_t joystick_tx_update(joystick_pos_t joy, slider_pos_t slider, uint8_t state);
+
+/**
+ * Copy the counters of one state; frames/s = (changes + heartbeats) * 1000 / time_ms.
+ */
+void joystick_tx_stats(uint8_t state, joystick_tx_stats_t* stats);
+
+/**
+ * Clear the counters of all states.
+ */
+void joystick_tx_stats_reset(void);
+
+#endif
@@ -4,6 +4,7 @@
 #include "test/sram/sram.h"
 #include "test/menu/menu.h"
 #include "test/game_menu/game_menu.h"
+#include "test/latency/latency.h"
 
 void setup(void) 
 {
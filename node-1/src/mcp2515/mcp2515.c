@@ -3,24 +3,28 @@
 // MCP2515 Chip Select pin - based on wiring tables (PE0)
 #define MCP2515_CS PE0
 
-// Helper function to select MCP2515
+// MCP2515 on the shared SPI bus: fck/2 (chip takes up to 10 MHz), mode 0, no gaps
+static const spi_device_t mcp2515_spi = SPI_DEVICE(PORTE, MCP2515_CS, 2, 0, 0, 0);
+
+// Descriptor for drivers that queue their own transactions (CAN interrupt chain)
+const spi_device_t* mcp2515_spi_device(void) {
+    return &mcp2515_spi;
+}
+
+// Helper function to select MCP2515 (waits for queued SPI transactions)
 static void mcp2515_select(void) {
-    PORTE &= ~(1 << MCP2515_CS);  // Pull CS low
+    spi_acquire(&mcp2515_spi);    // Pull CS low
 }
 
 // Helper function to deselect MCP2515  
 static void mcp2515_deselect(void) {
-    PORTE |= (1 << MCP2515_CS);   // Pull CS high
+    spi_release(&mcp2515_spi);    // Pull CS high
 }
 
 // Initialize MCP2515 driver (call this before using other functions)
 void mcp2515_init(void) {
-    // Initialize SPI first
-    SPI_MasterInit();
-    
-    // Set MCP2515 CS pin as output and deselect
-    DDRE |= (1 << MCP2515_CS);
-    mcp2515_deselect();
+    // Register with the SPI bus (CS pin as output, deselected)
+    spi_device_init(&mcp2515_spi);
     
     // Small delay to ensure MCP2515 is ready
     _delay_ms(10);
@@ -87,6 +91,53 @@ void mcp2515_bit_modify(uint8_t address, uint8_t mask, uint8_t data) {
     mcp2515_deselect();
 }
 
+// Read length consecutive registers starting at address
+void mcp2515_read_burst(uint8_t address, uint8_t* buffer, uint8_t length) {
+    mcp2515_select();
+    SPI_Transfer(MCP_READ);
+    SPI_Transfer(address);
+    for (uint8_t i = 0; i < length; i++) {
+        buffer[i] = SPI_Transfer(0x00);  // Address auto-increments
+    }
+    mcp2515_deselect();
+}
+
+// Write length consecutive registers starting at address
+void mcp2515_write_burst(uint8_t address, const uint8_t* buffer, uint8_t length) {
+    mcp2515_select();
+    SPI_Transfer(MCP_WRITE);
+    SPI_Transfer(address);
+    for (uint8_t i = 0; i < length; i++) {
+        SPI_Transfer(buffer[i]);
+    }
+    mcp2515_deselect();
+}
+
+// Fill a TX buffer with LOAD TX BUFFER: no address byte, starts at TXBnSIDH (or TXBnD0)
+void mcp2515_load_tx_buffer(uint8_t instruction, const uint8_t* buffer, uint8_t length) {
+    mcp2515_select();
+    SPI_Transfer(instruction);
+    for (uint8_t i = 0; i < length; i++) {
+        SPI_Transfer(buffer[i]);
+    }
+    mcp2515_deselect();
+}
+
+// Write a standard ID acceptance filter RXF0-RXF5 (SIDH, SIDL, EID8, EID0 in one burst)
+void mcp2515_write_filter(uint8_t filter, uint16_t id) {
+    static const uint8_t address[6] = {
+        MCP_RXF0SIDH, MCP_RXF1SIDH, MCP_RXF2SIDH, MCP_RXF3SIDH, MCP_RXF4SIDH, MCP_RXF5SIDH
+    };
+    uint8_t regs[4] = { (id >> 3) & 0xFF, (id << 5) & 0xE0, 0x00, 0x00 };  // EXIDE = 0
+    mcp2515_write_burst(address[filter], regs, sizeof(regs));
+}
+
+// Write acceptance mask RXM0/RXM1 (1 bits must match the filter)
+void mcp2515_write_mask(uint8_t mask, uint16_t bits) {
+    uint8_t regs[4] = { (bits >> 3) & 0xFF, (bits << 5) & 0xE0, 0x00, 0x00 };
+    mcp2515_write_burst(mask ? MCP_RXM1SIDH : MCP_RXM0SIDH, regs, sizeof(regs));
+}
+
 // Set MCP2515 to specified mode
 void mcp2515_set_mode(uint8_t mode) {
     mcp2515_bit_modify(MCP_CANCTRL, MODE_MASK, mode);
@@ -102,6 +153,9 @@ void mcp2515_set_mode(uint8_t mode) {
     }
 }
 
+// CNF3, CNF2, CNF1 are consecutive registers (0x28-0x2A), written in one burst
+static const uint8_t mcp2515_cnf[3] = { CAN_CNF3, CAN_CNF2, CAN_CNF1 };
+
 // Initialize MCP2515 for loopback mode (for testing)
 void mcp2515_init_loopback(void) {
     // Initialize the driver
@@ -113,29 +167,12 @@ void mcp2515_init_loopback(void) {
     // Set to configuration mode first
     mcp2515_set_mode(MODE_CONFIG);
     
-    // Configure bit timing for 250kbps (with 16MHz crystal)
-    // Bit rate calculation for MCP2515:
-    // - TQ (Time Quantum) = 2 * Tosc * (BRP + 1)
-    // - Bit Time = (SyncSeg + PropSeg + PS1 + PS2) * TQ
-    // - For 250 kbps with 16 MHz: Bit Time = 4 µs
-    //
-    // Configuration: BRP=1, 16 TQ per bit (MUST MATCH NODE 2!)
-    // - SyncSeg = 1 TQ (fixed)
-    // - PropSeg = 6 TQ (PRSEG register value = 5, actual = 6)
-    // - PS1 = 5 TQ (PHSEG1 register value = 4, actual = 5)
-    // - PS2 = 4 TQ (PHSEG2 register value = 3, actual = 4)
-    // - Total = 1 + 6 + 5 + 4 = 16 TQ
-    // - TQ = 2 * (1/16MHz) * (1+1) = 0.25 µs
-    // - Bit time = 16 * 0.25µs = 4µs = 250kbps ✓
-    // - Sample point = (1 + 6 + 5) / 16 = 75%
-    
-    mcp2515_write(MCP_CNF1, 0x01);  // SJW=1 (2TQ), BRP=1
-    mcp2515_write(MCP_CNF2, 0xB5);  // BTLMODE=1, SAM=0, PHSEG1=5, PRSEG=6 (0xB5 = 10110101)
-    mcp2515_write(MCP_CNF3, 0x03);  // SOF=0, WAKFIL=0, PHSEG2=4 (0x03 = 00000011)
+    // Bit timing from the profile shared with Node 2 (common/can_bitrate.h)
+    mcp2515_write_burst(MCP_CNF3, mcp2515_cnf, sizeof(mcp2515_cnf));
     
     // Configure RX buffer 0 to accept ALL messages (turn off filters)
     // RXB0CTRL: Accept all messages (standard + extended), rollover enabled
-    mcp2515_write(MCP_RXB0CTRL, 0x60);  // RXM[1:0] = 11 (turn off filters, accept all)
+    mcp2515_write(MCP_RXB0CTRL, MCP_RXM_ANY | MCP_BUKT);
     
     // Configure RX buffer 1 to accept ALL messages
     mcp2515_write(MCP_RXB1CTRL, 0x60);  // RXM[1:0] = 11 (turn off filters, accept all)
@@ -155,14 +192,11 @@ void mcp2515_init_normal(void) {
     // Set to configuration mode first
     mcp2515_set_mode(MODE_CONFIG);
     
-    // Working 125 kbps configuration from elinemha/TTK4155 repo
-    // 16MHz / (2 * (BRP+1) * 16TQ) = 16MHz / (2 * 4 * 16) = 125 kbps exactly
-    mcp2515_write(MCP_CNF1, 0x03);  // SJW=1, BRP=3 (divisor=4)
-    mcp2515_write(MCP_CNF2, 0xB1);  // BTLMODE=1, SAM=0, PHSEG1=7, PRSEG=2  
-    mcp2515_write(MCP_CNF3, 0x05);  // SOF=0, WAKFIL=0, PHSEG2=6
+    // Bit timing from the profile shared with Node 2 (common/can_bitrate.h)
+    mcp2515_write_burst(MCP_CNF3, mcp2515_cnf, sizeof(mcp2515_cnf));
     
-    // Configure RX buffer 0 to accept ALL messages (turn off filters)
-    mcp2515_write(MCP_RXB0CTRL, 0x60);  // RXM[1:0] = 11 (turn off filters, accept all)
+    // Configure RX buffer 0 to accept ALL messages (turn off filters), roll over into RXB1
+    mcp2515_write(MCP_RXB0CTRL, MCP_RXM_ANY | MCP_BUKT);
     
     // Configure RX buffer 1 to accept ALL messages
     mcp2515_write(MCP_RXB1CTRL, 0x60);  // RXM[1:0] = 11 (turn off filters, accept all)
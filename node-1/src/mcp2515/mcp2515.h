@@ -98,6 +98,29 @@ Copyright 2003 Kimberly Otten Software Consulting
 
 #define MCP_RX_STATUS	0xB0
 
+// LOAD TX start address select: the low bit skips the ID bytes
+#define MCP_LOAD_TX0_DATA	0x41
+#define MCP_LOAD_TX1_DATA	0x43
+#define MCP_LOAD_TX2_DATA	0x45
+
+// READ STATUS result bits
+#define MCP_STAT_RX0IF		0x01
+#define MCP_STAT_RX1IF		0x02
+#define MCP_STAT_TX0REQ		0x04
+#define MCP_STAT_TX0IF		0x08
+#define MCP_STAT_TX1REQ		0x10
+#define MCP_STAT_TX1IF		0x20
+#define MCP_STAT_TX2REQ		0x40
+#define MCP_STAT_TX2IF		0x80
+
+// RX STATUS result bits (message in RXB0/RXB1)
+#define MCP_RXSTAT_RXB0		0x40
+#define MCP_RXSTAT_RXB1		0x80
+
+// TX/RX buffer layout as read/written by LOAD TX and READ RX: SIDH SIDL EID8 EID0 DLC D0..D7
+#define MCP_FRAME_HEADER_LEN	5
+#define MCP_FRAME_MAX_LEN		(MCP_FRAME_HEADER_LEN + 8)
+
 #define MCP_RESET		0xC0
 
 
@@ -143,6 +166,20 @@ Copyright 2003 Kimberly Otten Software Consulting
 #define WAKFIL_DISABLE	0x00
 
 
+// TXBnCTRL Register Bits
+
+#define MCP_TXREQ		0x08
+#define MCP_TXP_MASK	0x03
+
+
+// RXB0CTRL Register Bits
+
+#define MCP_RXM_ANY		0x60		// RXM[1:0] = 11: filters off, receive everything
+#define MCP_BUKT		0x04		// Roll over into RXB1 when RXB0 is full
+#define MCP_FILHIT0		0x01		// RXB0CTRL: accepted by RXF1 (else RXF0)
+#define MCP_FILHIT_MASK	0x07		// RXB1CTRL: number of the accepting filter
+
+
 // CANINTF Register Bits
 
 #define MCP_RX0IF		0x01
@@ -154,10 +191,20 @@ Copyright 2003 Kimberly Otten Software Consulting
 #define MCP_WAKIF		0x40
 #define MCP_MERRF		0x80
 
+
+// EFLG Register Bits
+
+#define MCP_EFLG_EWARN	0x01		// TEC or REC >= 96
+#define MCP_EFLG_TXEP	0x10		// TX error passive (TEC >= 128)
+#define MCP_EFLG_TXBO	0x20		// Bus-off (TEC reached 255)
+#define MCP_EFLG_RX0OVR	0x40		// RXB0 overrun, cleared by software
+#define MCP_EFLG_RX1OVR	0x80		// RXB1 overrun, cleared by software
+
 // === MCP2515 Driver Function Declarations ===
 
 #include <stdint.h>
 #include "spi/spi.h"
+#include "can_bitrate.h"
 #include "uart/uart.h"
 #include "utils/utils.h"
 #include <util/delay.h>
@@ -173,6 +220,14 @@ void mcp2515_request_to_send(uint8_t buffer_select);       // Request to send (R
 uint8_t mcp2515_read_status(void);                         // Read status
 void mcp2515_bit_modify(uint8_t address, uint8_t mask, uint8_t data); // Bit modify
 
+// Burst access: one CS cycle and header for a whole run of bytes
+void mcp2515_read_burst(uint8_t address, uint8_t* buffer, uint8_t length);         // Sequential read
+void mcp2515_write_burst(uint8_t address, const uint8_t* buffer, uint8_t length);  // Sequential write
+void mcp2515_load_tx_buffer(uint8_t instruction, const uint8_t* buffer, uint8_t length); // LOAD TX (0x40-0x45)
+void mcp2515_write_filter(uint8_t filter, uint16_t id);     // RXFn standard ID (config mode)
+void mcp2515_write_mask(uint8_t mask, uint16_t bits);      // RXMn standard ID bits (config mode)
+const spi_device_t* mcp2515_spi_device(void);              // For queued (async) transactions
+
 // Higher level functions
 void mcp2515_set_mode(uint8_t mode);                       // Set operating mode
 void mcp2515_init_loopback(void);                          // Initialize for loopback mode
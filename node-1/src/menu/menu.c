@@ -1,362 +1,366 @@
-// Menu module - Complete implementation
+// Menu module - table-driven menu tree in PROGMEM
 #include "menu.h"
 
 // PROGMEM menu strings to save SRAM
-const char str_main_menu[] PROGMEM = "Main Menu";
-const char str_new_game[] PROGMEM = "New Game";
-const char str_high_score[] PROGMEM = "High Score";
-const char str_calibrate[] PROGMEM = "Calibrate";
-const char str_settings[] PROGMEM = "Settings";
-const char str_easy[] PROGMEM = "Easy";
-const char str_medium[] PROGMEM = "Medium";
-const char str_hard[] PROGMEM = "Hard";
-const char str_back[] PROGMEM = "Back";
-const char str_view[] PROGMEM = "View";
-const char str_reset[] PROGMEM = "Reset";
-const char str_upload[] PROGMEM = "Upload";
-const char str_joystick[] PROGMEM = "Joystick";
-const char str_slider[] PROGMEM = "Slider";
-const char str_test[] PROGMEM = "Test";
-const char str_difficulty[] PROGMEM = "Difficulty";
-const char str_debug[] PROGMEM = "Debug";
-const char str_about[] PROGMEM = "About";
-
-// Menu system variables (moved from main.c)
-typedef enum {
-    MAIN_MENU,
-    SUB_MENU
-} menu_state_t;
-
-menu_state_t current_menu = MAIN_MENU;   // Current menu level
-uint8_t menu_selection = 0;              // Currently selected menu item
-uint8_t submenu_selection = 0;           // Currently selected submenu item
-uint8_t selected_main_item = 0;          // Which main menu item was selected
-uint8_t last_menu_selection = 255;       // Previous menu selection for change detection
-bool last_button_state = false;          // Last joystick button state
-uint8_t navigation_counter = 0;          // Counter for navigation debouncing
+static const char str_main_menu[] PROGMEM = "Main Menu";
+static const char str_new_game[] PROGMEM = "New Game";
+static const char str_high_score[] PROGMEM = "High Score";
+static const char str_calibrate[] PROGMEM = "Calibrate";
+static const char str_settings[] PROGMEM = "Settings";
+static const char str_easy[] PROGMEM = "Easy";
+static const char str_medium[] PROGMEM = "Medium";
+static const char str_hard[] PROGMEM = "Hard";
+static const char str_back[] PROGMEM = "Back";
+static const char str_view[] PROGMEM = "View";
+static const char str_reset[] PROGMEM = "Reset";
+static const char str_upload[] PROGMEM = "Upload";
+static const char str_joystick[] PROGMEM = "Joystick";
+static const char str_slider[] PROGMEM = "Slider";
+static const char str_test[] PROGMEM = "Test";
+static const char str_difficulty[] PROGMEM = "Difficulty";
+static const char str_debug[] PROGMEM = "Debug";
+static const char str_about[] PROGMEM = "About";
 
+// Messages of the "press the button" action screens
+static const char msg_start_easy[] PROGMEM = "Starting Easy";
+static const char msg_start_medium[] PROGMEM = "Starting Med";
+static const char msg_start_hard[] PROGMEM = "Starting Hard";
+static const char msg_view_scores[] PROGMEM = "Viewing Scores";
+static const char msg_reset_scores[] PROGMEM = "Scores Reset";
+static const char msg_upload_scores[] PROGMEM = "Uploading...";
+static const char msg_difficulty[] PROGMEM = "Difficulty Set";
+static const char msg_debug[] PROGMEM = "Debug Mode";
+static const char msg_about[] PROGMEM = "Game v1.0";
 
+enum {
+    MENU_MSG_START_EASY,    // + difficulty
+    MENU_MSG_START_MEDIUM,
+    MENU_MSG_START_HARD,
+    MENU_MSG_VIEW_SCORES,
+    MENU_MSG_RESET_SCORES,
+    MENU_MSG_UPLOAD_SCORES,
+    MENU_MSG_DIFFICULTY,
+    MENU_MSG_DEBUG,
+    MENU_MSG_ABOUT
+};
 
-void display_menu(void)
+static PGM_P const menu_messages[] PROGMEM = {
+    msg_start_easy, msg_start_medium, msg_start_hard,
+    msg_view_scores, msg_reset_scores, msg_upload_scores,
+    msg_difficulty, msg_debug, msg_about
+};
+
+static const char menu_nav_task_name[] PROGMEM = "menu";
+static const char menu_action_task_name[] PROGMEM = "menu act";
+
+#define MENU_TEST_HOLD_MS  2000     // Test screen shows its instructions this long first
+
+
+// === Input ===
+
+static bool menu_last_button = true;    // Starts pressed so a held button is not a press
+
+// Rising edge of the button given its current state
+static bool menu_button_edge(bool button)
+{
+    bool pressed = button && !menu_last_button;
+    menu_last_button = button;
+    return pressed;
+}
+
+// Joystick button or the I/O board nav button (cached by the ioboard_service task)
+static bool menu_select_held(bool joy_button)
+{
+    return joy_button || (ioboard_get_buttons().nav & IOBOARD_NAV_BTN);
+}
+
+bool menu_button_pressed(void)
+{
+    return menu_button_edge(menu_select_held(joystick_get_position().button));
+}
+
+
+// === Actions ===
+
+// Message on page 2, button prompt on page 4
+static void menu_show_message(PGM_P message)
 {
     oled_clear_screen();
-    oled_print_string_P(str_main_menu, 0, 0);
+    oled_print_string_P(message, 0, 2);
+    oled_print_string_P(PSTR("Press joy btn"), 0, 4);
+    oled_flush_async();
+}
+
+// Show menu_messages[arg] until the button is pressed
+static uint8_t menu_action_message(uint8_t arg, uint8_t step)
+{
+    if (step == 0) {
+        menu_show_message(pgm_read_ptr(&menu_messages[arg]));
+        return 1;
+    }
+    return menu_button_pressed() ? MENU_ACTION_DONE : 1;
+}
+
+// arg: 0 easy, 1 medium, 2 hard
+static uint8_t menu_action_new_game(uint8_t arg, uint8_t step)
+{
+    if (step == 0) {
+        // Difficulty picks the joystick response curve
+        static const joystick_curve_t curves[] = {
+            JOYSTICK_CURVE_SOFT, JOYSTICK_CURVE_LINEAR, JOYSTICK_CURVE_SHARP
+        };
+        joystick_set_curve(curves[arg]);
+    }
+    return menu_action_message(MENU_MSG_START_EASY + arg, step);
+}
+
+// arg: 0 joystick, 1 slider. Bounds follow the stick until the button is pressed.
+static uint8_t menu_action_calibrate(uint8_t arg, uint8_t step)
+{
+    bool slider = arg;
     
-    // Display each menu item directly to save RAM
-    for (uint8_t i = 0; i < 4; i++) {
-        // Show cursor for selected item
-        if (i == menu_selection) {
-            oled_print_char('>', 0, i + 2);  // Cursor at start of line
-        } else {
-            oled_print_char(' ', 0, i + 2);  // Space for unselected items
-        }
-        
-        // Display menu item text directly from PROGMEM
-        switch(i) {
-            case 0: oled_print_string_P(str_new_game, 8, i + 2); break;
-            case 1: oled_print_string_P(str_high_score, 8, i + 2); break;
-            case 2: oled_print_string_P(str_calibrate, 8, i + 2); break;
-            case 3: oled_print_string_P(str_settings, 8, i + 2); break;
-        }
+    switch (step) {
+        case 0:
+            oled_clear_screen();
+            oled_print_string_P(slider ? PSTR("Calib Slider") : PSTR("Calibrating..."), 0, 1);
+            oled_print_string_P(slider ? PSTR("Move finger") : PSTR("Move joystick"), 0, 2);
+            oled_print_string_P(PSTR("around fully"), 0, 3);
+            oled_print_string_P(PSTR("Press joy btn"), 0, 4);
+            oled_print_string_P(PSTR("when done"), 0, 5);
+            oled_flush_async();
+            
+            if (slider) {
+                slider_reset_calibration();
+            } else {
+                joystick_reset_calibration();
+            }
+            return 1;
+            
+        case 1:
+            if (slider) {
+                slider_calibrate_now();
+            } else {
+                joystick_calibrate_now();
+            }
+            if (!menu_button_pressed()) {
+                return 1;
+            }
+            
+            // Show completion message
+            oled_clear_screen();
+            oled_print_string_P(slider ? PSTR("Slider Calib") : PSTR("Calibration"), 0, 1);
+            oled_print_string_P(PSTR("Complete!"), 0, 2);
+            oled_print_string_P(PSTR("Press joy btn"), 0, 4);
+            oled_flush_async();
+            joystick_save_calibration();
+            printf_P(slider ? PSTR("Slider calibrated!\r\n") : PSTR("Joystick calibrated!\r\n"));
+            return 2;
+            
+        default:
+            return menu_button_pressed() ? MENU_ACTION_DONE : 2;
     }
 }
 
-void display_submenu(void)
+// Live joystick/slider readout until the button is pressed
+static uint8_t menu_action_test(uint8_t arg, uint8_t step)
 {
-    oled_clear_screen();
+    static uint16_t shown_at;
+    (void)arg;
     
-    // Display title based on selected main menu item
-    switch(selected_main_item) {
-        case 0: oled_print_string_P(str_new_game, 0, 0); break;
-        case 1: oled_print_string_P(str_high_score, 0, 0); break;
-        case 2: oled_print_string_P(str_calibrate, 0, 0); break;
-        case 3: oled_print_string_P(str_settings, 0, 0); break;
+    if (step == 0) {
+        oled_clear_screen();
+        oled_print_string_P(PSTR("Test Mode"), 0, 0);
+        oled_print_string_P(PSTR("Press joy btn"), 0, 1);
+        oled_print_string_P(PSTR("to exit"), 0, 2);
+        oled_flush_async();
+        shown_at = sched_now();
+        return 1;
+    }
+    if (step == 1) {
+        menu_button_pressed();  // Presses while the instructions show are ignored
+        return (uint16_t)(sched_now() - shown_at) >= MENU_TEST_HOLD_MS ? 2 : 1;
     }
     
-    // Display submenu items based on which main menu was selected
-    for (uint8_t i = 0; i < 4; i++) {
-        // Show cursor for selected item
-        if (i == submenu_selection) {
-            oled_print_char('>', 0, i + 2);  // Cursor at start of line
-        } else {
-            oled_print_char(' ', 0, i + 2);  // Space for unselected items
-        }
+    if (menu_button_pressed()) {
+        printf_P(PSTR("Exited test mode\r\n"));
+        return MENU_ACTION_DONE;
+    }
+    // Steps 2 and 3 alternate: the readout updates every other period (100 ms)
+    if (step == 2) {
+        display_joystick();
+        return 3;
+    }
+    return 2;
+}
+
+
+// === Menu tree ===
+
+#define MENU_CHILDREN(nodes) nodes, sizeof(nodes) / sizeof(nodes[0])
+#define MENU_BACK { str_back, NULL, 0, NULL, 0 }
+
+static const menu_node_t menu_new_game[] PROGMEM = {
+    { str_easy,   NULL, 0, menu_action_new_game, 0 },
+    { str_medium, NULL, 0, menu_action_new_game, 1 },
+    { str_hard,   NULL, 0, menu_action_new_game, 2 },
+    MENU_BACK
+};
+
+static const menu_node_t menu_high_score[] PROGMEM = {
+    { str_view,   NULL, 0, menu_action_message, MENU_MSG_VIEW_SCORES },
+    { str_reset,  NULL, 0, menu_action_message, MENU_MSG_RESET_SCORES },
+    { str_upload, NULL, 0, menu_action_message, MENU_MSG_UPLOAD_SCORES },
+    MENU_BACK
+};
+
+static const menu_node_t menu_calibrate[] PROGMEM = {
+    { str_joystick, NULL, 0, menu_action_calibrate, 0 },
+    { str_slider,   NULL, 0, menu_action_calibrate, 1 },
+    { str_test,     NULL, 0, menu_action_test, 0 },
+    MENU_BACK
+};
+
+static const menu_node_t menu_settings[] PROGMEM = {
+    { str_difficulty, NULL, 0, menu_action_message, MENU_MSG_DIFFICULTY },
+    { str_debug,      NULL, 0, menu_action_message, MENU_MSG_DEBUG },
+    { str_about,      NULL, 0, menu_action_message, MENU_MSG_ABOUT },
+    MENU_BACK
+};
+
+static const menu_node_t menu_main[] PROGMEM = {
+    { str_new_game,   MENU_CHILDREN(menu_new_game),   NULL, 0 },
+    { str_high_score, MENU_CHILDREN(menu_high_score), NULL, 0 },
+    { str_calibrate,  MENU_CHILDREN(menu_calibrate),  NULL, 0 },
+    { str_settings,   MENU_CHILDREN(menu_settings),   NULL, 0 },
+};
+
+static const menu_node_t menu_root PROGMEM = { str_main_menu, MENU_CHILDREN(menu_main), NULL, 0 };
+
+
+// === Engine ===
+
+static const menu_node_t* menu_path[MENU_MAX_DEPTH] = { &menu_root };  // Open node per level
+static uint8_t menu_selection[MENU_MAX_DEPTH];  // Cursor per level, kept while a child is open
+static uint8_t menu_depth = 0;
+static uint8_t navigation_counter = 0;          // Periods the stick has been held deflected
+
+// Running action (NULL when the menu has the input)
+static menu_action_t menu_action = NULL;
+static uint8_t menu_action_arg;
+static uint8_t menu_action_step;
+static uint8_t menu_action_id = SCHED_INVALID;
+
+static void menu_read_node(const menu_node_t* node_P, menu_node_t* node)
+{
+    memcpy_P(node, node_P, sizeof(*node));
+}
+
+void display_menu(void)
+{
+    menu_node_t node, child;
+    menu_read_node(menu_path[menu_depth], &node);
+    
+    oled_clear_screen();
+    oled_print_string_P(node.label, 0, 0);
+    for (uint8_t i = 0; i < node.child_count; i++) {
+        menu_read_node(&node.children[i], &child);
+        oled_print_string_P(child.label, 8, MENU_FIRST_LINE + i);
+    }
+    oled_print_char('>', 0, MENU_FIRST_LINE + menu_selection[menu_depth]);
+    oled_flush_async();
+}
+
+// Only the two cursor characters change
+static void menu_move_cursor(uint8_t from, uint8_t to)
+{
+    oled_print_char(' ', 0, MENU_FIRST_LINE + from);
+    oled_print_char('>', 0, MENU_FIRST_LINE + to);
+    oled_flush_async();
+}
+
+static void menu_action_task(void)
+{
+    menu_action_step = menu_action(menu_action_arg, menu_action_step);
+    if (menu_action_step == MENU_ACTION_DONE) {
+        sched_cancel(menu_action_id);
+        menu_action = NULL;
+        display_menu();
+    }
+}
+
+static void menu_select(const menu_node_t* node_P)
+{
+    menu_node_t node;
+    menu_read_node(node_P, &node);
+    
+    if (node.children && menu_depth + 1 < MENU_MAX_DEPTH) {
+        TLOG("Entered submenu for item %d\n", menu_selection[menu_depth]);
+        menu_depth++;
+        menu_path[menu_depth] = node_P;
+        menu_selection[menu_depth] = 0;
+        display_menu();
         
-        // Display context-specific submenu items from PROGMEM
-        switch(selected_main_item) {
-            case 0: // New Game submenu
-                switch(i) {
-                    case 0: oled_print_string_P(str_easy, 8, i + 2); break;
-                    case 1: oled_print_string_P(str_medium, 8, i + 2); break;
-                    case 2: oled_print_string_P(str_hard, 8, i + 2); break;
-                    case 3: oled_print_string_P(str_back, 8, i + 2); break;
-                }
-                break;
-            case 1: // High Score submenu  
-                switch(i) {
-                    case 0: oled_print_string_P(str_view, 8, i + 2); break;
-                    case 1: oled_print_string_P(str_reset, 8, i + 2); break;
-                    case 2: oled_print_string_P(str_upload, 8, i + 2); break;
-                    case 3: oled_print_string_P(str_back, 8, i + 2); break;
-                }
-                break;
-            case 2: // Calibrate submenu
-                switch(i) {
-                    case 0: oled_print_string_P(str_joystick, 8, i + 2); break;
-                    case 1: oled_print_string_P(str_slider, 8, i + 2); break;
-                    case 2: oled_print_string_P(str_test, 8, i + 2); break;
-                    case 3: oled_print_string_P(str_back, 8, i + 2); break;
-                }
-                break;
-            case 3: // Settings submenu
-                switch(i) {
-                    case 0: oled_print_string_P(str_difficulty, 8, i + 2); break;
-                    case 1: oled_print_string_P(str_debug, 8, i + 2); break;
-                    case 2: oled_print_string_P(str_about, 8, i + 2); break;
-                    case 3: oled_print_string_P(str_back, 8, i + 2); break;
-                }
-                break;
+    } else if (node.action) {
+        TLOG("Selected: Main=%d, Sub=%d\n", menu_selection[0], menu_selection[menu_depth]);
+        menu_action = node.action;
+        menu_action_arg = node.arg;
+        menu_action_step = 0;
+        menu_action_id = sched_add(menu_action_task, MENU_ACTION_MS, 0, SCHED_PRIO_INPUT, menu_action_task_name);
+        if (menu_action_id == SCHED_INVALID) {
+            printf_P(PSTR("Menu: no task slot for action\r\n"));
+            menu_action = NULL;
         }
+        
+    } else if (menu_depth > 0) {
+        // "Back": the parent's cursor is still where it was left
+        menu_depth--;
+        TLOG("Returned to menu level %d\n", menu_depth);
+        display_menu();
     }
 }
 
 void menu_selector(void)
 {
-       // Read joystick position and button from ADC/GPIO
+    if (menu_action) {
+        return;     // The action task owns the screen and the button
+    }
+    
+    // Read joystick position and button from ADC/GPIO
     joystick_pos_t joy_pos = joystick_get_position();
     
-    // Get current selection pointer based on menu state
-    uint8_t* current_selection = (current_menu == MAIN_MENU) ? &menu_selection : &submenu_selection;
+    menu_node_t node;
+    menu_read_node(menu_path[menu_depth], &node);
+    uint8_t* current_selection = &menu_selection[menu_depth];
     
-    // Handle up/down navigation with proper debouncing
-    // Use larger dead zones and counter-based debouncing to prevent noise
+    // Up/down with counter-based debouncing: the stick must stay deflected
+    // for several periods, which also sets the auto-repeat rate
+    int8_t step = 0;
     if (joy_pos.x > 90) {
-        // Joystick moved up
-        navigation_counter++;
-        if (navigation_counter > 3) {  // Require multiple consecutive readings
-            if (*current_selection > 0) {
-                (*current_selection)--;
-            }
-            navigation_counter = 0;  // Reset counter
-        }
+        step = -1;      // Joystick moved up
     } else if (joy_pos.x < 25) {
-        // Joystick moved down  
-        navigation_counter++;
-        if (navigation_counter > 3) {  // Require multiple consecutive readings
-            if (*current_selection < 3) {
-                (*current_selection)++;
-            }
-            navigation_counter = 0;  // Reset counter
-        }
-    } else {
-        // Joystick in neutral position
-        navigation_counter = 0;
+        step = 1;       // Joystick moved down
     }
     
-    // Handle selection using joystick center button (connected to PB1)
-    if (joy_pos.button && !last_button_state) {
-        // Button pressed (rising edge)
-        
-        if (current_menu == MAIN_MENU) {
-            // Main menu selection - enter submenu
-            selected_main_item = menu_selection;
-            current_menu = SUB_MENU;
-            submenu_selection = 0;  // Reset submenu selection
-            printf_P(PSTR("Entered submenu for item %d\r\n"), selected_main_item);
-            
-        } else {
-            // Submenu selection
-            if (submenu_selection == 3) {
-                // "Back" option selected - return to main menu
-                current_menu = MAIN_MENU;
-                printf_P(PSTR("Returned to main menu\r\n"));
-            } else {
-                // Handle specific submenu actions
-                printf_P(PSTR("Selected: Main=%d, Sub=%d\r\n"), selected_main_item, submenu_selection);
-                
-                // Execute specific actions based on selection
-                switch(selected_main_item) {
-                    case 0: // New Game
-                        oled_clear_screen();
-                        switch(submenu_selection) {
-                            case 0: oled_print_string("Starting Easy", 0, 2); break;
-                            case 1: oled_print_string("Starting Med", 0, 2); break; 
-                            case 2: oled_print_string("Starting Hard", 0, 2); break;
-                        }
-                        oled_print_string("Press joy btn", 0, 4);
-                        // Wait for joystick button press
-                        while (1) {
-                            joystick_pos_t joy = joystick_get_position();
-                            if (joy.button) break;
-                            _delay_ms(50);
-                        }
-                        break;
-                    case 1: // High Score
-                        oled_clear_screen();
-                        switch(submenu_selection) {
-                            case 0: oled_print_string("Viewing Scores", 0, 2); break;
-                            case 1: oled_print_string("Scores Reset", 0, 2); break;
-                            case 2: oled_print_string("Uploading...", 0, 2); break;
-                        }
-                        oled_print_string("Press joy btn", 0, 4);
-                        // Wait for joystick button press
-                        while (1) {
-                            joystick_pos_t joy = joystick_get_position();
-                            if (joy.button) break;
-                            _delay_ms(50);
-                        }
-                        break;
-                    case 2: // Calibrate
-                        switch(submenu_selection) {
-                            case 0: // Calibrate Joystick
-                                oled_clear_screen();
-                                oled_print_string("Calibrating...", 0, 1);
-                                oled_print_string("Move joystick", 0, 2);
-                                oled_print_string("around fully", 0, 3);
-                                oled_print_string("Press joy btn", 0, 4);
-                                oled_print_string("when done", 0, 5);
-                                
-                                joystick_reset_calibration();
-                                
-                                // Calibration loop - continuously update calibration
-                                bool calibrating = true;
-                                while (calibrating) {
-                                    // Read raw ADC without triggering calibration in joystick_get_position()
-                                    uint16_t adc_x = adc_read(1);  // JOYSTICK_ADC_X_CHANNEL
-                                    uint16_t adc_y = adc_read(0);  // JOYSTICK_ADC_Y_CHANNEL
-                                    
-                                    // Manually call calibration with raw values
-                                    joystick_calibrate_now();
-                                    
-                                    // Check for button press to finish calibration
-                                    joystick_pos_t joy = joystick_get_position();
-                                    if (joy.button) {
-                                        calibrating = false;
-                                        
-                                        // Wait for button release to avoid immediate menu selection
-                                        while (joy.button) {
-                                            joy = joystick_get_position();
-                                            _delay_ms(50);
-                                        }
-                                    }
-                                    _delay_ms(50);
-                                }
-                                
-                                // Show completion message
-                                oled_clear_screen();
-                                oled_print_string("Calibration", 0, 1);
-                                oled_print_string("Complete!", 0, 2);
-                                oled_print_string("Press joy btn", 0, 4);
-                                printf_P(PSTR("Joystick calibrated!\r\n"));
-                                
-                                // Wait for button press to continue
-                                while (1) {
-                                    joystick_pos_t joy = joystick_get_position();
-                                    if (joy.button) break;
-                                    _delay_ms(50);
-                                }
-                                break;
-                            case 1: // Calibrate Slider  
-                                oled_clear_screen();
-                                oled_print_string("Calib Slider", 0, 1);
-                                oled_print_string("Move finger", 0, 2);
-                                oled_print_string("around fully", 0, 3);
-                                oled_print_string("Press joy btn", 0, 4);
-                                oled_print_string("when done", 0, 5);
-                                
-                                slider_reset_calibration();
-                                
-                                // Calibration loop - continuously update calibration
-                                bool slider_calibrating = true;
-                                while (slider_calibrating) {
-                                    // Manually call slider calibration with current values
-                                    slider_calibrate_now();
-                                    
-                                    // Check for button press to finish calibration
-                                    joystick_pos_t joy = joystick_get_position();
-                                    if (joy.button) {
-                                        slider_calibrating = false;
-                                        
-                                        // Wait for button release to avoid immediate menu selection
-                                        while (joy.button) {
-                                            joy = joystick_get_position();
-                                            _delay_ms(50);
-                                        }
-                                    }
-                                    _delay_ms(50);
-                                }
-                                
-                                // Show completion message
-                                oled_clear_screen();
-                                oled_print_string("Slider Calib", 0, 1);
-                                oled_print_string("Complete!", 0, 2);
-                                oled_print_string("Press joy btn", 0, 4);
-                                printf_P(PSTR("Slider calibrated!\r\n"));
-                                
-                                // Wait for button press to continue
-                                while (1) {
-                                    joystick_pos_t joy = joystick_get_position();
-                                    if (joy.button) break;
-                                    _delay_ms(50);
-                                }
-                                break;
-                            case 2: // Test - Show live joystick display
-                                // Enter test mode - continuous display until button pressed
-                                oled_clear_screen();
-                                oled_print_string("Test Mode", 0, 0);
-                                oled_print_string("Press joy btn", 0, 1);
-                                oled_print_string("to exit", 0, 2);
-                                _delay_ms(2000);
-                                
-                                // Test loop - show joystick values until button pressed
-                                while (1) {
-                                    display_joystick();
-                                    joystick_pos_t test_joy = joystick_get_position();
-                                    if (test_joy.button) {
-                                        break; // Exit test mode
-                                    }
-                                }
-                                printf_P(PSTR("Exited test mode\r\n"));
-                                break;
-                        }
-                        break;
-                    case 3: // Settings
-                        oled_clear_screen();
-                        switch(submenu_selection) {
-                            case 0: oled_print_string("Difficulty Set", 0, 2); break;
-                            case 1: oled_print_string("Debug Mode", 0, 2); break;
-                            case 2: oled_print_string("Game v1.0", 0, 2); break;
-                        }
-                        oled_print_string("Press joy btn", 0, 4);
-                        // Wait for joystick button press
-                        while (1) {
-                            joystick_pos_t joy = joystick_get_position();
-                            if (joy.button) break;
-                            _delay_ms(50);
-                        }
-                        break;
-                }
-            }
+    if (step == 0) {
+        navigation_counter = 0;
+    } else if (++navigation_counter > MENU_NAV_REPEAT) {
+        navigation_counter = 0;
+        uint8_t next = *current_selection + step;
+        if (next < node.child_count) {      // -1 wraps to 255 and is rejected too
+            menu_move_cursor(*current_selection, next);
+            *current_selection = next;
         }
-        
-        // Force menu redraw
-        last_menu_selection = 255;
     }
     
-    // Only redraw menu if selection changed (reduces flickering)
-    uint8_t current_sel = (current_menu == MAIN_MENU) ? menu_selection : submenu_selection;
-    if (current_sel != last_menu_selection) {
-        if (current_menu == MAIN_MENU) {
-            display_menu();
-        } else {
-            display_submenu();
-        }
-        last_menu_selection = current_sel;
+    if (menu_button_edge(menu_select_held(joy_pos.button))) {
+        menu_select(&node.children[*current_selection]);
     }
-    
-    // Update button state for debouncing
-    last_button_state = joy_pos.button;
-    
-    _delay_ms(50); // Small delay for responsiveness
 }
-// Empty stub functions to avoid linker errors
\ No newline at end of file
+
+void menu_init(void)
+{
+    menu_depth = 0;
+    menu_selection[0] = 0;
+    display_menu();
+    sched_add(menu_selector, MENU_NAV_MS, 0, SCHED_PRIO_INPUT, menu_nav_task_name);
+}
@@ -8,102 +8,58 @@
 #include "joystick/joystick.h"
 #include "ioboard/ioboard.h"
 #include "adc/adc.h"
+#include "tlog.h"
+#include "sched/sched.h"
 #include <util/delay.h>
 #include <avr/pgmspace.h>
 
-// Menu configuration constants - ULTRA MINIMAL for ATmega162
-#define MAX_MENU_ITEMS     4    // Maximum items per menu 
-#define MAX_MENU_TEXT_LEN  8    // Maximum length of menu item text
-#define MENU_DISPLAY_LINES 4    // How many menu lines fit on OLED
-
-//MENU SYSTEM
-
-void display_menu(void);
-void display_submenu(void);
-void menu_selector(void);
-
-
-
-// Menu item types
-typedef enum {
-    MENU_ITEM_ACTION,    // Executes a function when selected
-    MENU_ITEM_SUBMENU,   // Opens a sub-menu
-    MENU_ITEM_BACK       // Returns to parent menu
-} menu_item_type_t;
-
-// Forward declarations
-typedef struct menu_t menu_t;
-typedef struct menu_item_t menu_item_t;
-
-// Menu item action function pointer
-typedef void (*menu_action_func_t)(void);
-
-// Menu item structure
-struct menu_item_t {
-    char text[MAX_MENU_TEXT_LEN];        // Display text
-    menu_item_type_t type;               // Item type
-    union {
-        menu_action_func_t action;       // Function to call (ACTION type)
-        menu_t* submenu;                 // Pointer to submenu (SUBMENU type)
-    };
+// Menu layout: title on page 0, items from page MENU_FIRST_LINE down
+#define MENU_FIRST_LINE    2
+#define MENU_MAX_DEPTH     3    // Root plus two levels of submenus
+#define MENU_NAV_MS        50   // Navigation task period
+#define MENU_ACTION_MS     50   // Action task period
+#define MENU_NAV_REPEAT    3    // Navigation periods a deflection must hold before the cursor moves
+
+/*
+ * Table-driven menu. The whole tree is const data in flash: each node has a
+ * label, optional children and an optional action. Selecting a node with
+ * children opens it, a node with neither is "Back", and a node with an action
+ * starts it as a scheduler task.
+ *
+ * Actions are step functions: called every MENU_ACTION_MS with the node's arg
+ * and the step they returned last time (0 on the first call), they return the
+ * next step or MENU_ACTION_DONE. They never wait; "press the button" screens
+ * return the same step until menu_button_pressed() is true.
+ *
+ * Moving the cursor only redraws the old and new cursor characters; the full
+ * screen is drawn when a menu is opened, closed or an action finishes.
+ */
+
+#define MENU_ACTION_DONE   0xFF
+
+typedef uint8_t (*menu_action_t)(uint8_t arg, uint8_t step);
+
+typedef struct menu_node_t menu_node_t;
+
+struct menu_node_t {
+    PGM_P label;
+    const menu_node_t* children;    // PROGMEM array of child_count nodes, or NULL
+    uint8_t child_count;
+    menu_action_t action;           // Leaf action, or NULL
+    uint8_t arg;                    // Passed to action (e.g. which difficulty)
 };
 
-// Menu structure
-struct menu_t {
-    char title[MAX_MENU_TEXT_LEN];       // Menu title
-    menu_item_t items[MAX_MENU_ITEMS];   // Menu items
-    uint8_t item_count;                  // Number of items in menu
-    uint8_t selected_item;               // Currently selected item index
-    uint8_t scroll_offset;               // Scroll offset for long menus
-    menu_t* parent;                      // Parent menu (for back navigation)
-};
-
-// Menu system state
-typedef struct {
-    menu_t* current_menu;                // Currently active menu
-    menu_t* root_menu;                   // Root menu
-    bool menu_active;                    // Is menu system active?
-    bool needs_redraw;                   // Does display need update?
-} menu_system_t;
-
-// Menu navigation directions
-typedef enum {
-    MENU_NAV_UP,
-    MENU_NAV_DOWN,
-    MENU_NAV_SELECT,
-    MENU_NAV_BACK
-} menu_navigation_t;
-
-// === Public Menu Functions ===
-
-// Initialize menu system
+// Draw the root menu and start the navigation task (needs sched_init)
 void menu_init(void);
 
-// Create a new menu
-menu_t* menu_create(const char* title, menu_t* parent);
-
-// Add menu items
-void menu_add_action_item(menu_t* menu, const char* text, menu_action_func_t action);
-void menu_add_submenu_item(menu_t* menu, const char* text, menu_t* submenu);
-void menu_add_back_item(menu_t* menu);
-
-// Menu navigation
-void menu_navigate(menu_navigation_t direction);
-void menu_set_active(menu_t* menu);
-void menu_close(void);
-
-// Menu display
-void menu_update(void);
-void menu_draw(void);
-
-// Menu input handling (call from main loop)
-void menu_handle_joystick(void);
+// Redraw the current menu level from scratch
+void display_menu(void);
 
-// Get menu system state
-bool menu_is_active(void);
-uint8_t menu_get_selected_position(void);
+// Navigation step: joystick up/down moves the cursor, button opens/selects.
+// Runs as a scheduler task after menu_init; does nothing while an action runs.
+void menu_selector(void);
 
-// === Example Setup Function ===
-void menu_setup_example(void);
+// Rising edge of the joystick or I/O board nav button since the last call (for actions)
+bool menu_button_pressed(void);
 
 #endif
\ No newline at end of file
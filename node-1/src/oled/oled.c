@@ -1,29 +1,113 @@
 #include "oled.h"
 // fonts.h MUST be included in the .c file (for some reason)
 #include "fonts/fonts.h"
+#include "profile/profile.h"
 
-// Write command to OLED
-void oled_write_command(uint8_t cmd) {
-    PORTB &= ~(1 << OLED_CS);   // Select OLED
+// Framebuffer lives in external SRAM, taken from the xmem arena by oled_init()
+static uint8_t* oled_fb;
+
+// Addressing mode the panel is currently in
+static oled_addr_mode_t oled_addr_mode = OLED_ADDR_PAGE;
+
+// Changed column range per page (inclusive), empty when first > last
+static uint8_t dirty_first[OLED_PAGES];
+static uint8_t dirty_last[OLED_PAGES];
+
+// Mark the whole display as changed (display RAM content is unknown)
+void oled_invalidate(void) {
+    for (uint8_t page = 0; page < OLED_PAGES; page++) {
+        dirty_first[page] = 0;
+        dirty_last[page] = OLED_WIDTH - 1;
+    }
+}
+
+// Write one column byte to the framebuffer, only marking it dirty if it changed
+static void oled_fb_put(uint8_t page, uint8_t column, uint8_t value) {
+    uint8_t* p = &oled_fb[(uint16_t)page * OLED_WIDTH + column];
+    if (*p == value) return;
+    *p = value;
+    
+    if (dirty_first[page] > dirty_last[page]) {
+        dirty_first[page] = dirty_last[page] = column;
+    } else if (column < dirty_first[page]) {
+        dirty_first[page] = column;
+    } else if (column > dirty_last[page]) {
+        dirty_last[page] = column;
+    }
+}
+
+// Fill the whole framebuffer with one byte value
+static void oled_fb_fill(uint8_t value) {
+    for (uint8_t page = 0; page < OLED_PAGES; page++) {
+        for (uint8_t col = 0; col < OLED_WIDTH; col++) {
+            oled_fb_put(page, col, value);
+        }
+    }
+}
+
+// OLED on the shared SPI bus: CS on PB3, fck/2 (SSD1306 takes up to 10 MHz), mode 0
+static const spi_device_t oled_spi = SPI_DEVICE(PORTB, OLED_CS, 2, 0, 0, 0);
+
+// Start a command run: everything streamed until oled_end() is a command byte
+void oled_begin_command(void) {
+    spi_acquire(&oled_spi);     // Wait for the bus (an async flush may own DC), select OLED
     PORTB &= ~(1 << OLED_DC);   // Command mode (DC low)
+}
+
+// Start a data run: everything streamed until oled_end() goes to display RAM
+void oled_begin_data(void) {
+    spi_acquire(&oled_spi);     // Wait for the bus (an async flush may own DC), select OLED
+    PORTB |= (1 << OLED_DC);    // Data mode (DC high)
+}
+
+// Send one byte in the current run (no CS toggle, no delay)
+void oled_stream(uint8_t byte) {
+    SPI_MasterTransmit(byte);
+}
+
+// Send a buffer in the current run
+void oled_stream_buffer(const uint8_t* buf, uint16_t len) {
+    while (len--) {
+        SPI_MasterTransmit(*buf++);
+    }
+}
+
+// End the current run
+void oled_end(void) {
+    spi_release(&oled_spi);     // Deselect OLED
+}
+
+// Write a single command to OLED (own CS cycle, prefer a command run for several)
+void oled_write_command(uint8_t cmd) {
+    oled_begin_command();
     SPI_MasterTransmit(cmd);
-    PORTB |= (1 << OLED_CS);    // Deselect OLED
+    oled_end();
     _delay_us(1);               // Small delay for stability
 }
 
-// Write data to OLED
+// Write a single data byte to OLED (own CS cycle, prefer a data run for several)
 void oled_write_data(uint8_t data) {
-    PORTB &= ~(1 << OLED_CS);   // Select OLED
-    PORTB |= (1 << OLED_DC);    // Data mode (DC high)
+    oled_begin_data();
     SPI_MasterTransmit(data);
-    PORTB |= (1 << OLED_CS);    // Deselect OLED
+    oled_end();
     _delay_us(1);               // Small delay for stability
 }
 
 // Simple OLED initialization
 void oled_init(void) {
-    // Set control pins as outputs
-    DDRB |= (1 << OLED_DC) | (1 << OLED_CS);
+    oled_init_mode(OLED_DEFAULT_ADDR_MODE);
+}
+
+// OLED initialization with a chosen addressing mode
+void oled_init_mode(oled_addr_mode_t mode) {
+    // Framebuffer is in external SRAM, allocated once
+    if (oled_fb == NULL) {
+        oled_fb = xmem_arena_alloc_or_halt(OLED_FB_SIZE, PSTR("OLED"));
+    }
+    
+    // Set control pins as outputs, CS is handled by the SPI bus manager
+    spi_device_init(&oled_spi);
+    DDRB |= (1 << OLED_DC);
     DDRD |= (1 << OLED_RES);
     
     // Reset sequence
@@ -32,72 +116,304 @@ void oled_init(void) {
     PORTD |= (1 << OLED_RES);   // Reset high
     _delay_ms(10);
     
-    // Lab manual recommended minimal initialization:
-    oled_write_command(OLED_SEGREMAP);              // A1 - Segment remap (lab manual)
-    oled_write_command(OLED_COMSCANDEC);            // C8 - COM scan direction (lab manual)  
-    oled_write_command(OLED_DISPLAYON);             // AF - Display ON (lab manual)
+    // Lab manual recommended minimal initialization, sent as one command run:
+    oled_begin_command();
+    oled_stream(OLED_SEGREMAP);                     // A1 - Segment remap (lab manual)
+    oled_stream(OLED_COMSCANDEC);                   // C8 - COM scan direction (lab manual)  
+    oled_stream(OLED_DISPLAYON);                    // AF - Display ON (lab manual)
+    oled_end();
     
-    // Set Page Mode (default and easiest according to lab manual)
-    oled_write_command(OLED_MEMORYMODE);            // Set memory addressing mode
-    oled_write_command(OLED_PAGE_MODE);             // Page addressing mode (0x10)
+    oled_set_addr_mode(mode);
 
-    oled_clear_screen();                            // Clear screen on init 
+    // Display RAM is undefined after reset: clear framebuffer and resend everything
+    for (uint16_t i = 0; i < OLED_FB_SIZE; i++) {
+        oled_fb[i] = 0x00;
+    }
+    oled_invalidate();
+    oled_flush();
+}
+
+// Switch addressing mode (page mode is the lab manual default)
+void oled_set_addr_mode(oled_addr_mode_t mode) {
+    uint8_t value = OLED_PAGE_MODE;
+    if (mode == OLED_ADDR_HORIZONTAL) value = OLED_HORIZONTAL_MODE;
+    if (mode == OLED_ADDR_VERTICAL) value = OLED_VERTICAL_MODE;
+    
+    oled_begin_command();
+    oled_stream(OLED_MEMORYMODE);
+    oled_stream(value);
+    oled_end();
+    
+    oled_addr_mode = mode;
+}
+
+oled_addr_mode_t oled_get_addr_mode(void) {
+    return oled_addr_mode;
+}
+
+// Set the column/page window for Horizontal/Vertical Mode (bounds inclusive)
+void oled_set_window(uint8_t col_start, uint8_t col_end, uint8_t page_start, uint8_t page_end) {
+    oled_begin_command();
+    oled_stream(OLED_COLUMN_ADDR);
+    oled_stream(col_start);
+    oled_stream(col_end);
+    oled_stream(OLED_PAGE_ADDR);
+    oled_stream(page_start);
+    oled_stream(page_end);
+    oled_end();
 }
 
 // Set cursor position using Page Mode (lab manual recommendation)
 void oled_set_cursor_page_mode(uint8_t page, uint8_t column) {
+    oled_begin_command();
+    
     // Set page address (0xB0 + page number)
-    oled_write_command(OLED_SET_PAGE_ADDR + (page & 0x07));
+    oled_stream(OLED_SET_PAGE_ADDR + (page & 0x07));
     
     // Set column address (split into low and high nibbles)
-    oled_write_command(OLED_SET_COL_LOW + (column & 0x0F));       // Lower 4 bits
-    oled_write_command(OLED_SET_COL_HIGH + ((column >> 4) & 0x0F)); // Upper 4 bits
+    oled_stream(OLED_SET_COL_LOW + (column & 0x0F));       // Lower 4 bits
+    oled_stream(OLED_SET_COL_HIGH + ((column >> 4) & 0x0F)); // Upper 4 bits
+    
+    oled_end();
 }
 
-// Fill entire screen white using Page Mode (lab manual approach)
-void oled_fill_screen_white(void) {
-    // Fill each page (row) one by one
-    for (uint8_t page = 0; page < 8; page++) {
-        oled_set_cursor_page_mode(page, 0);  // Set to start of page
+// One step of a flush: a command run or a data run taken from the framebuffer
+typedef struct {
+    uint8_t is_data;
+    const uint8_t* buf;
+    uint8_t len;
+} oled_piece_t;
+
+// Flush in progress: snapshot of the dirty ranges and the position within it.
+// Drawing during an (async) flush marks the live dirty ranges, not this copy.
+static struct {
+    uint8_t first[OLED_PAGES];
+    uint8_t last[OLED_PAGES];
+    uint8_t next_page;                  // First page not covered by a window yet
+    uint8_t in_window;
+    uint8_t col_start, col_end, page_start, page_end;
+    uint8_t pos;                        // Next page (or column in vertical mode) to send
+    uint8_t cmd[OLED_WINDOW_CMD_BYTES];
+    uint8_t column[OLED_PAGES];         // Vertical mode gathers one column here
+} oled_fs;
+
+static void oled_flush_snapshot(void) {
+    for (uint8_t page = 0; page < OLED_PAGES; page++) {
+        oled_fs.first[page] = dirty_first[page];
+        oled_fs.last[page] = dirty_last[page];
+        dirty_first[page] = 0xFF;   // Mark clean
+        dirty_last[page] = 0;
+    }
+    oled_fs.next_page = 0;
+    oled_fs.in_window = 0;
+}
+
+// Find the next rectangle to send. Page mode: one changed page at a time.
+// Horizontal/Vertical Mode: consecutive changed pages are merged into one rectangle
+// as long as the extra unchanged bytes cost less than a new window setup.
+static uint8_t oled_flush_find_window(void) {
+    uint8_t page = oled_fs.next_page;
+    while (page < OLED_PAGES && oled_fs.first[page] > oled_fs.last[page]) {
+        page++;
+    }
+    if (page >= OLED_PAGES) return 0;
+    
+    uint8_t page_start = page;
+    uint8_t col_start = oled_fs.first[page];
+    uint8_t col_end = oled_fs.last[page];
+    uint16_t changed = col_end - col_start + 1;  // Bytes that actually need sending
+    
+    while (++page < OLED_PAGES && oled_addr_mode != OLED_ADDR_PAGE
+           && oled_fs.first[page] <= oled_fs.last[page]) {
+        uint8_t new_start = oled_fs.first[page] < col_start ? oled_fs.first[page] : col_start;
+        uint8_t new_end = oled_fs.last[page] > col_end ? oled_fs.last[page] : col_end;
+        uint16_t new_changed = changed + (oled_fs.last[page] - oled_fs.first[page] + 1);
+        uint16_t rect = (uint16_t)(new_end - new_start + 1) * (page - page_start + 1);
+        
+        if (rect - new_changed > OLED_WINDOW_CMD_BYTES) break;  // Cheaper as its own window
         
-        // Fill entire page (128 columns) with white pixels
-        for (uint8_t col = 0; col < 128; col++) {
-            oled_write_data(0xFF);
+        col_start = new_start;
+        col_end = new_end;
+        changed = new_changed;
+    }
+    
+    oled_fs.next_page = page;
+    oled_fs.col_start = col_start;
+    oled_fs.col_end = col_end;
+    oled_fs.page_start = page_start;
+    oled_fs.page_end = page - 1;
+    return 1;
+}
+
+// Produce the next piece of the flush, 0 when done
+static uint8_t oled_flush_next(oled_piece_t* piece) {
+    if (oled_fs.in_window) {
+        piece->is_data = 1;
+        if (oled_addr_mode == OLED_ADDR_VERTICAL) {
+            // Column by column, top page to bottom page
+            if (oled_fs.pos <= oled_fs.col_end) {
+                uint8_t n = 0;
+                for (uint8_t page = oled_fs.page_start; page <= oled_fs.page_end; page++) {
+                    oled_fs.column[n++] = oled_fb[(uint16_t)page * OLED_WIDTH + oled_fs.pos];
+                }
+                piece->buf = oled_fs.column;
+                piece->len = n;
+                oled_fs.pos++;
+                return 1;
+            }
+        } else if (oled_fs.pos <= oled_fs.page_end) {
+            // Page by page, left to right
+            piece->buf = &oled_fb[(uint16_t)oled_fs.pos * OLED_WIDTH + oled_fs.col_start];
+            piece->len = oled_fs.col_end - oled_fs.col_start + 1;
+            oled_fs.pos++;
+            return 1;
         }
+        oled_fs.in_window = 0;
     }
+    
+    if (!oled_flush_find_window()) return 0;
+    
+    uint8_t* cmd = oled_fs.cmd;
+    if (oled_addr_mode == OLED_ADDR_PAGE) {
+        cmd[0] = OLED_SET_PAGE_ADDR + oled_fs.page_start;
+        cmd[1] = OLED_SET_COL_LOW + (oled_fs.col_start & 0x0F);
+        cmd[2] = OLED_SET_COL_HIGH + ((oled_fs.col_start >> 4) & 0x0F);
+        piece->len = 3;
+    } else {
+        cmd[0] = OLED_COLUMN_ADDR;
+        cmd[1] = oled_fs.col_start;
+        cmd[2] = oled_fs.col_end;
+        cmd[3] = OLED_PAGE_ADDR;
+        cmd[4] = oled_fs.page_start;
+        cmd[5] = oled_fs.page_end;
+        piece->len = OLED_WINDOW_CMD_BYTES;
+    }
+    piece->is_data = 0;
+    piece->buf = cmd;
+    oled_fs.in_window = 1;
+    oled_fs.pos = (oled_addr_mode == OLED_ADDR_VERTICAL) ? oled_fs.col_start : oled_fs.page_start;
+    return 1;
 }
 
-// Clear screen (turn black) using Page Mode (lab manual approach)
-void oled_clear_screen(void) {
-    // Clear each page (row) one by one
-    for (uint8_t page = 0; page < 8; page++) {
-        oled_set_cursor_page_mode(page, 0);  // Set to start of page
-        
-        // Clear entire page (128 columns) with black pixels
-        for (uint8_t col = 0; col < 128; col++) {
-            oled_write_data(0x00);
+// Send only the changed parts of the framebuffer to the display (blocking)
+void oled_flush(void) {
+    oled_flush_wait();
+    oled_flush_snapshot();
+    
+    // Consecutive pieces of the same kind share one CS/DC run
+    uint8_t run = 0xFF;
+    oled_piece_t piece;
+    while (oled_flush_next(&piece)) {
+        if (piece.is_data != run) {
+            if (run != 0xFF) oled_end();
+            if (piece.is_data) {
+                oled_begin_data();
+            } else {
+                oled_begin_command();
+            }
+            run = piece.is_data;
         }
+        oled_stream_buffer(piece.buf, piece.len);
     }
+    if (run != 0xFF) oled_end();
 }
 
-// Print a single character at position (x, y) using Page Mode
+// === Async flush: one SPI transaction per piece, chained from the completion callback ===
+static spi_transaction_t oled_txn;
+static volatile uint8_t oled_async_busy = 0;
+static volatile uint8_t oled_txn_pending = 0;   // oled_txn is set up but the SPI queue was full
+
+static void oled_txn_start_command(spi_transaction_t* t) {
+    (void)t;
+    PORTB &= ~(1 << OLED_DC);
+}
+
+static void oled_txn_start_data(spi_transaction_t* t) {
+    (void)t;
+    PORTB |= (1 << OLED_DC);
+}
+
+static void oled_txn_done(spi_transaction_t* t);
+
+// Queue oled_txn, or keep it pending for oled_txn_retry() when the bus queue is full
+static void oled_txn_submit(void) {
+    oled_txn_pending = !spi_submit(&oled_txn);
+}
+
+// Main context: resubmit a piece the bus queue had no room for. Nothing of ours is
+// on the bus while it is pending, so the SPI interrupt cannot race this.
+static void oled_txn_retry(void) {
+    if (oled_txn_pending) oled_txn_submit();
+}
+
+static void oled_txn_queue_next(void) {
+    oled_piece_t piece;
+    if (!oled_flush_next(&piece)) {
+        oled_async_busy = 0;
+        return;
+    }
+    oled_txn.device = &oled_spi;
+    oled_txn.tx = piece.buf;
+    oled_txn.tx_len = piece.len;
+    oled_txn.rx = 0;
+    oled_txn.len = piece.len;
+    oled_txn.start = piece.is_data ? oled_txn_start_data : oled_txn_start_command;
+    oled_txn.done = oled_txn_done;
+    oled_txn_submit();          // The snapshot is already marked clean, never drop a piece
+}
+
+static void oled_txn_done(spi_transaction_t* t) {
+    (void)t;
+    oled_txn_queue_next();
+}
+
+// Start sending the changed parts in the background and return immediately
+void oled_flush_async(void) {
+    oled_flush_wait();
+    oled_flush_snapshot();
+    oled_async_busy = 1;
+    oled_txn_queue_next();
+}
+
+uint8_t oled_flush_busy(void) {
+    oled_txn_retry();
+    return oled_async_busy;
+}
+
+void oled_flush_wait(void) {
+    while (oled_async_busy) {
+        oled_txn_retry();
+    }
+}
+
+// Fill entire screen white (framebuffer only, see oled_flush)
+void oled_fill_screen_white(void) {
+    oled_fb_fill(0xFF);
+}
+
+// Clear screen (framebuffer only, see oled_flush)
+// Redrawing the same content afterwards only resends the columns that changed
+void oled_clear_screen(void) {
+    oled_fb_fill(0x00);
+}
+
+// Print a single character at position (x, y), where y is the page
 void oled_print_char(char c, uint8_t x, uint8_t y) {
     if (c < 32 || c > 126) return; // Only printable ASCII
     
     uint8_t char_index = c - 32; // Font array starts at space (ASCII 32)
+    uint8_t page = y & 0x07;     // Same wrap-around as the page address command
     
-    // Set position using page mode
-    oled_set_cursor_page_mode(y, x);
-    
-    // Send character bitmap (8 pixels wide)
-    for (uint8_t i = 0; i < 8; i++) {
+    // Copy character bitmap (8 pixels wide) into the framebuffer
+    for (uint8_t i = 0; i < 8 && (uint8_t)(x + i) < OLED_WIDTH; i++) {
         uint8_t column = pgm_read_byte(&font8[char_index][i]);
-        oled_write_data(column);
+        oled_fb_put(page, x + i, column);
     }
 }
 
 // Print a string at position (x, y)
 void oled_print_string(char* str, uint8_t x, uint8_t y) {
+    PROFILE_SCOPE("oled_print_string");
     uint8_t pos_x = x;
     
     while (*str && pos_x < 120) { // Don't go off screen
@@ -5,6 +5,7 @@
 #include <avr/io.h>
 #include <stdint.h>
 #include "spi/spi.h"
+#include "xmem/xmem.h"
 #include <util/delay.h>
 #include <avr/pgmspace.h>
 
@@ -13,6 +14,9 @@
 #define OLED_HEIGHT 64
 #define OLED_PAGES  8   // 64 pixels / 8 = 8 pages
 
+// Framebuffer in external SRAM (xmem arena, taken by oled_init), one byte per column per page
+#define OLED_FB_SIZE (OLED_WIDTH * OLED_PAGES)
+
 // OLED Control pins (from spi.h)
 #define OLED_DC   PB2   // Data/Command pin
 #define OLED_CS   PB3   // Chip Select pin  
@@ -29,21 +33,61 @@
 #define OLED_NORMALDISPLAY          0xA6
 #define OLED_MEMORYMODE             0x20
 
+// Memory addressing mode values (argument to OLED_MEMORYMODE, only bits 1:0 are used)
+#define OLED_HORIZONTAL_MODE        0x00    // Horizontal Addressing Mode (page wraps to next page)
+#define OLED_VERTICAL_MODE          0x01    // Vertical Addressing Mode (column wraps to next column)
+#define OLED_PAGE_MODE              0x02    // Page Addressing Mode (reset default)
+
 // Page Mode Commands (lab manual recommendation - easiest to use)
-#define OLED_PAGE_MODE              0x10    // Page Addressing Mode (default)
 #define OLED_SET_PAGE_ADDR          0xB0    // Set page address (0xB0-0xB7)
 #define OLED_SET_COL_LOW            0x00    // Set lower column address (0x00-0x0F)
 #define OLED_SET_COL_HIGH           0x10    // Set higher column address (0x10-0x1F)
 
+// Horizontal/Vertical Mode Commands (each followed by start and end argument)
+#define OLED_COLUMN_ADDR            0x21    // Set column window (0-127)
+#define OLED_PAGE_ADDR              0x22    // Set page window (0-7)
+
+// Bytes needed to set up a window, used to decide when merging pages is cheaper
+#define OLED_WINDOW_CMD_BYTES       6
+
+typedef enum {
+    OLED_ADDR_PAGE,         // Cursor set per page with 0xB0/0x00/0x10 commands
+    OLED_ADDR_HORIZONTAL,   // Rectangle streamed row (page) by row via 0x21/0x22 window
+    OLED_ADDR_VERTICAL      // Rectangle streamed column by column via 0x21/0x22 window
+} oled_addr_mode_t;
+
+// Addressing mode used by oled_init()
+#ifndef OLED_DEFAULT_ADDR_MODE
+#define OLED_DEFAULT_ADDR_MODE OLED_ADDR_HORIZONTAL
+#endif
+
 // Function declarations
-void oled_init(void);
+// Drawing functions only update the framebuffer; call oled_flush() to show the result
+void oled_init(void);                             // Init with OLED_DEFAULT_ADDR_MODE
+void oled_init_mode(oled_addr_mode_t mode);       // Init with a specific addressing mode
+void oled_set_addr_mode(oled_addr_mode_t mode);   // Switch addressing mode at runtime
+oled_addr_mode_t oled_get_addr_mode(void);
 void oled_write_command(uint8_t cmd);
 void oled_write_data(uint8_t data);
+
+// Streaming: CS (and DC) set once per run, bytes sent back to back until oled_end()
+void oled_begin_command(void);      // Start a command run (CS low, DC low)
+void oled_begin_data(void);         // Start a data run (CS low, DC high)
+void oled_stream(uint8_t byte);     // Send one byte in the current run
+void oled_stream_buffer(const uint8_t* buf, uint16_t len); // Send len bytes in the current run
+void oled_end(void);                // End the run (CS high)
+
 void oled_fill_screen_white(void);
 void oled_clear_screen(void);
 void oled_print_char(char c, uint8_t x, uint8_t y);
 void oled_print_string(char* str, uint8_t x, uint8_t y);
 void oled_print_string_P(const char* str, uint8_t x, uint8_t y);
 void oled_set_cursor_page_mode(uint8_t page, uint8_t column);
+void oled_set_window(uint8_t col_start, uint8_t col_end, uint8_t page_start, uint8_t page_end);
+void oled_flush(void);              // Send changed column ranges of each page to the display
+void oled_flush_async(void);        // Same, but queued on the SPI bus and returns immediately
+uint8_t oled_flush_busy(void);      // 1 while an async flush is still sending
+void oled_flush_wait(void);         // Block until an async flush has finished
+void oled_invalidate(void);         // Mark the whole display as changed (next flush resends all)
 
 #endif
@@ -0,0 +1,78 @@
+#include "profile.h"
+#include <stdio.h>
+
+static profile_region_t profile_table[PROFILE_REGIONS];
+static uint8_t profile_used;
+static uint16_t profile_overhead;   // Ticks an empty region takes
+
+void profile_init(void)
+{
+    cpu_time_init();
+    profile_used = 0;
+    
+    // Cheapest of a few empty regions, so the overhead is never overestimated
+    profile_overhead = 0xFFFF;
+    for (uint8_t i = 0; i < 8; i++) {
+        cpu_ticks_t start = cpu_time_ticks();
+        cpu_ticks_t elapsed = cpu_time_ticks() - start;
+        if (elapsed < profile_overhead) profile_overhead = elapsed;
+    }
+}
+
+// Compare two names that both live in flash (strcmp_P wants the first one in RAM)
+static uint8_t profile_name_equal(PGM_P a, PGM_P b)
+{
+    for (;;) {
+        char c = pgm_read_byte(a++);
+        if (c != pgm_read_byte(b++)) return 0;
+        if (c == '\0') return 1;
+    }
+}
+
+void profile_record(uint8_t* slot, PGM_P name, cpu_ticks_t elapsed)
+{
+    if (*slot == PROFILE_NONE) {
+        // First sample of this call site: same name elsewhere shares the region
+        for (uint8_t i = 0; i < profile_used; i++) {
+            if (profile_table[i].name == name || profile_name_equal(name, profile_table[i].name)) {
+                *slot = i;
+                break;
+            }
+        }
+        if (*slot == PROFILE_NONE) {
+            if (profile_used >= PROFILE_REGIONS) return;
+            *slot = profile_used++;
+            profile_table[*slot] = (profile_region_t){ .name = name, .min = 0xFFFF };
+        }
+    }
+    
+    elapsed = elapsed > profile_overhead ? elapsed - profile_overhead : 0;
+    uint16_t ticks = elapsed > 0xFFFF ? 0xFFFF : (uint16_t)elapsed;
+    
+    profile_region_t* region = &profile_table[*slot];
+    if (region->count == 0xFFFF) return;   // Mean stays valid, table wants a dump
+    region->count++;
+    region->total += ticks;
+    if (ticks < region->min) region->min = ticks;
+    if (ticks > region->max) region->max = ticks;
+}
+
+void profile_dump(void)
+{
+    printf_P(PSTR("\r\n=== Profile (us, %u ticks overhead removed) ===\r\n"), profile_overhead);
+    printf_P(PSTR("region                count      min     mean      max\r\n"));
+    for (uint8_t i = 0; i < profile_used; i++) {
+        profile_region_t* region = &profile_table[i];
+        if (region->count == 0) continue;
+        printf_P(PSTR("%-20S %6u %8lu %8lu %8lu\r\n"), region->name, region->count,
+                 CPU_TICKS_TO_US(region->min),
+                 CPU_TICKS_TO_US(region->total / region->count),
+                 CPU_TICKS_TO_US(region->max));
+        
+        // Keep the regions (and the call sites' slots), start a new measurement
+        region->count = 0;
+        region->total = 0;
+        region->min = 0xFFFF;
+        region->max = 0;
+    }
+}
@@ -0,0 +1,102 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <stdint.h>
+#include <avr/pgmspace.h>
+#include "cpu_time/cpu_time.h"
+
+/*
+ * Region profiler on the raw Timer1 ticks.
+ *
+ *    void oled_print_string(...) {
+ *        PROFILE_SCOPE("oled_print_string");     // Until the end of the block
+ *        ...
+ *    }
+ *
+ *    PROFILE_BEGIN(spi);
+ *    ...
+ *    PROFILE_END(spi, "spi burst");              // Named region without a scope
+ *
+ * Every region keeps count, min, max and total ticks in a static table; the
+ * cost of an empty region (measured in profile_init) is taken off every sample.
+ * Regions are meant for the main loop, not for interrupts.
+ *
+ * The macros compile to nothing unless PROFILE_ENABLED is 1 (add
+ * -DPROFILE_ENABLED=1 to CFLAGS in the Makefile), so instrumented drivers cost
+ * nothing in normal builds.
+ */
+
+#ifndef PROFILE_ENABLED
+#define PROFILE_ENABLED     0
+#endif
+
+#define PROFILE_REGIONS     8       // Regions beyond this are ignored
+#define PROFILE_QUERY       'p'     // UART command that prints the table
+
+typedef struct {
+    PGM_P name;
+    uint16_t count;
+    uint16_t min;           // Ticks, saturated at 0xFFFF (~107 ms)
+    uint16_t max;
+    uint32_t total;
+} profile_region_t;
+
+typedef struct {
+    uint8_t* slot;          // Call site's cached table index
+    PGM_P name;
+    cpu_ticks_t start;
+} profile_scope_t;
+
+#define PROFILE_NONE        0xFF
+
+/**
+ * Clear the table and measure the overhead of an empty region (starts cpu_time).
+ */
+void profile_init(void);
+
+/**
+ * Add one sample. `slot` caches the table index for the call site (PROFILE_NONE at first).
+ */
+void profile_record(uint8_t* slot, PGM_P name, cpu_ticks_t elapsed);
+
+/**
+ * Print count, min, mean and max per region in microseconds, then clear it.
+ */
+void profile_dump(void);
+
+// For PROFILE_SCOPE (cleanup handler)
+static inline void profile_scope_end(profile_scope_t* scope)
+{
+    profile_record(scope->slot, scope->name, cpu_time_ticks() - scope->start);
+}
+
+#define PROFILE_CAT_(a, b)  a##b
+#define PROFILE_CAT(a, b)   PROFILE_CAT_(a, b)
+
+#if PROFILE_ENABLED
+
+#define PROFILE_SCOPE(label) \
+    static const char PROFILE_CAT(profile_name_, __LINE__)[] PROGMEM = label; \
+    static uint8_t PROFILE_CAT(profile_slot_, __LINE__) = PROFILE_NONE; \
+    profile_scope_t PROFILE_CAT(profile_scope_, __LINE__) __attribute__((cleanup(profile_scope_end))) = { \
+        &PROFILE_CAT(profile_slot_, __LINE__), PROFILE_CAT(profile_name_, __LINE__), cpu_time_ticks() }
+
+#define PROFILE_BEGIN(var) \
+    cpu_ticks_t profile_start_##var = cpu_time_ticks()
+
+#define PROFILE_END(var, label) do { \
+        cpu_ticks_t profile_elapsed = cpu_time_ticks() - profile_start_##var; \
+        static const char profile_name[] PROGMEM = label; \
+        static uint8_t profile_slot = PROFILE_NONE; \
+        profile_record(&profile_slot, profile_name, profile_elapsed); \
+    } while (0)
+
+#else
+
+#define PROFILE_SCOPE(label)        do { } while (0)
+#define PROFILE_BEGIN(var)          do { } while (0)
+#define PROFILE_END(var, label)     do { } while (0)
+
+#endif
+
+#endif
@@ -0,0 +1,166 @@
+#include "sched.h"
+#include "cpu_time/cpu_time.h"
+#include <stdio.h>
+#include <util/delay.h>
+
+// Timer1 ticks per ms is 614.4: 614 every tick plus one extra every 2 of 5 ticks
+#define SCHED_TICKS_PER_MS      ((uint16_t)(CPU_TICKS_PER_SECOND / 1000))
+
+typedef struct {
+    sched_fn_t fn;
+    PGM_P name;
+    uint16_t period_ms;         // 0 = one-shot
+    uint16_t due;               // sched_now() value of the next run
+    uint8_t priority;
+    bool running;               // Inside fn (a sched_delay_ms in it must not re-enter)
+    uint16_t runs;
+    uint16_t overruns;          // Started a whole period late
+    uint16_t late_max_ms;
+    uint16_t run_max_ticks;     // Longest single run
+} sched_task_t;
+
+static sched_task_t sched_tasks[SCHED_MAX_TASKS];
+static volatile uint16_t sched_ms;
+static uint8_t sched_frac;
+static bool sched_started = false;
+
+ISR(TIMER1_COMPB_vect)
+{
+    OCR1B += SCHED_TICKS_PER_MS;
+    sched_frac += 2;
+    if (sched_frac >= 5) {
+        sched_frac -= 5;
+        OCR1B++;
+    }
+    sched_ms++;
+}
+
+void sched_init(void)
+{
+    cpu_time_init();
+    for (uint8_t i = 0; i < SCHED_MAX_TASKS; i++) {
+        sched_tasks[i].fn = 0;
+    }
+    
+    uint8_t sreg = SREG;
+    cli();
+    sched_ms = 0;
+    OCR1B = TCNT1 + SCHED_TICKS_PER_MS;
+    TIFR = (1 << OCF1B);
+    TIMSK |= (1 << OCIE1B);
+    SREG = sreg;
+    sched_started = true;
+}
+
+uint16_t sched_now(void)
+{
+    uint8_t sreg = SREG;
+    cli();
+    uint16_t now = sched_ms;
+    SREG = sreg;
+    return now;
+}
+
+uint8_t sched_add(sched_fn_t fn, uint16_t period_ms, uint16_t delay_ms, uint8_t priority, PGM_P name)
+{
+    for (uint8_t i = 0; i < SCHED_MAX_TASKS; i++) {
+        if (sched_tasks[i].fn == 0) {
+            sched_tasks[i] = (sched_task_t){
+                .fn = fn,
+                .name = name,
+                .period_ms = period_ms,
+                .due = sched_now() + delay_ms,
+                .priority = priority,
+            };
+            return i;
+        }
+    }
+    return SCHED_INVALID;
+}
+
+void sched_cancel(uint8_t id)
+{
+    if (id < SCHED_MAX_TASKS) {
+        sched_tasks[id].fn = 0;
+    }
+}
+
+// Highest-priority due task that is not already running, SCHED_INVALID if none
+static uint8_t sched_next_due(uint16_t now)
+{
+    uint8_t best = SCHED_INVALID;
+    for (uint8_t i = 0; i < SCHED_MAX_TASKS; i++) {
+        sched_task_t* task = &sched_tasks[i];
+        if (task->fn == 0 || task->running || (int16_t)(now - task->due) < 0) continue;
+        if (best == SCHED_INVALID || task->priority < sched_tasks[best].priority) {
+            best = i;
+        }
+    }
+    return best;
+}
+
+static void sched_dispatch(uint8_t id, uint16_t now)
+{
+    sched_task_t* task = &sched_tasks[id];
+    uint16_t late = now - task->due;
+    if (late > task->late_max_ms) task->late_max_ms = late;
+    
+    if (task->period_ms == 0) {
+        task->due = now;        // Unused, the task is removed after the run
+    } else if (late >= task->period_ms) {
+        task->overruns++;
+        task->due = now + task->period_ms;      // Drop the missed runs
+    } else {
+        task->due += task->period_ms;
+    }
+    
+    sched_fn_t fn = task->fn;
+    task->running = true;
+    cpu_ticks_t start = cpu_time_ticks();
+    fn();
+    cpu_ticks_t ticks = cpu_time_ticks() - start;
+    task->running = false;
+    
+    task->runs++;
+    if (ticks > task->run_max_ticks) {
+        task->run_max_ticks = ticks > 0xFFFF ? 0xFFFF : (uint16_t)ticks;
+    }
+    if (task->period_ms == 0 && task->fn == fn) {
+        task->fn = 0;           // One-shot done (unless it re-armed the slot)
+    }
+}
+
+void sched_run(void)
+{
+    uint8_t id;
+    while ((id = sched_next_due(sched_now())) != SCHED_INVALID) {
+        sched_dispatch(id, sched_now());
+    }
+}
+
+void sched_delay_ms(uint16_t ms)
+{
+    if (!sched_started) {
+        while (ms--) {
+            _delay_ms(1);
+        }
+        return;
+    }
+    
+    uint16_t until = sched_now() + ms;
+    while ((int16_t)(sched_now() - until) < 0) {
+        sched_run();
+    }
+}
+
+void sched_print(void)
+{
+    printf_P(PSTR("\r\n=== Tasks ===\r\n"));
+    printf_P(PSTR("task       period prio   runs overruns late ms  max us\r\n"));
+    for (uint8_t i = 0; i < SCHED_MAX_TASKS; i++) {
+        sched_task_t* task = &sched_tasks[i];
+        if (task->fn == 0) continue;
+        printf_P(PSTR("%-10S %6u %4u %6u %8u %7u %7lu\r\n"), task->name, task->period_ms, task->priority,
+                 task->runs, task->overruns, task->late_max_ms, CPU_TICKS_TO_US(task->run_max_ticks));
+    }
+}
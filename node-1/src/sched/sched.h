@@ -0,0 +1,71 @@
+#ifndef SCHED_H
+#define SCHED_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <avr/pgmspace.h>
+
+/*
+ * Cooperative scheduler on a 1 ms tick (Timer1 compare B, Timer1 shared with
+ * cpu_time and the ADC sampler).
+ *
+ * Tasks are plain functions that do one step and return. sched_run() runs
+ * every due task, highest priority first, and is called from the main loop.
+ * Periodic tasks keep their phase (next = due + period); a task that starts a
+ * whole period late counts an overrun and skips the missed runs.
+ *
+ * Code that has to wait (a "press the button" screen) calls sched_delay_ms()
+ * instead of _delay_ms(), so the other tasks keep running while it waits.
+ */
+
+#define SCHED_MAX_TASKS     8
+#define SCHED_QUERY         't'     // UART command that prints the task table
+
+// Lower value runs first when several tasks are due
+#define SCHED_PRIO_CONTROL  0       // CAN TX/RX
+#define SCHED_PRIO_INPUT    1       // Sampling, UI state
+#define SCHED_PRIO_DISPLAY  2
+#define SCHED_PRIO_LOW      3       // Reports, statistics
+
+#define SCHED_INVALID       0xFF
+
+typedef void (*sched_fn_t)(void);
+
+/**
+ * Start the 1 ms tick (starts cpu_time if needed) and clear the task table.
+ */
+void sched_init(void);
+
+/**
+ * Add a task. period_ms 0 makes it one-shot; it first runs after delay_ms.
+ * name is a PROGMEM string for sched_print. Returns the task id or SCHED_INVALID.
+ */
+uint8_t sched_add(sched_fn_t fn, uint16_t period_ms, uint16_t delay_ms, uint8_t priority, PGM_P name);
+
+/**
+ * Remove a task (also from inside the task itself).
+ */
+void sched_cancel(uint8_t id);
+
+/**
+ * Run every task that is due, highest priority first. Call from the main loop.
+ */
+void sched_run(void);
+
+/**
+ * Wait, running other due tasks meanwhile (the calling task is not re-entered).
+ * Falls back to a busy wait if sched_init has not been called.
+ */
+void sched_delay_ms(uint16_t ms);
+
+/**
+ * Milliseconds since sched_init (wraps after 65 s; compare with differences).
+ */
+uint16_t sched_now(void);
+
+/**
+ * Runs, overruns, worst lateness and worst run time per task.
+ */
+void sched_print(void);
+
+#endif
@@ -1,5 +1,6 @@
 #include "spi.h"
 #include <avr/pgmspace.h>
+#include <avr/interrupt.h>
 
 // USE SPI Mode 0
 // Modes to decide clock polarity and phase
@@ -75,6 +76,165 @@ return SPDR;
 
 
 
+// === SPI bus manager ===
+// Timer2 (CTC, fck/8) times the gaps some devices need between bytes.
+#define SPI_GAP_PRESCALE    8
+#define SPI_GAP_TICKS(us)   ((uint8_t)(((uint32_t)(us) * (F_CPU / SPI_GAP_PRESCALE) + 999999UL) / 1000000UL))
+
+static spi_transaction_t* volatile spi_queue[SPI_QUEUE_LEN];
+static volatile uint8_t spi_queue_head = 0;     // Next to start
+static volatile uint8_t spi_queue_count = 0;
+static spi_transaction_t* volatile spi_current = 0;  // Running transaction
+static volatile uint8_t spi_locked = 0;         // Blocking session in progress
+static volatile uint16_t spi_pos = 0;           // Index of the byte on the wire
+static uint8_t spi_bus_ready = 0;
+
+static void spi_bus_init(void)
+{
+    if (spi_bus_ready) return;
+
+    // SS must be an output (driven high) or a low level would drop us out of master mode
+    DDRB |= (1 << SPI_MOSI) | (1 << SPI_SCK) | (1 << SPI_SS);
+    PORTB |= (1 << SPI_SS);
+    SPCR = (1 << SPE) | (1 << MSTR) | (1 << SPR0);
+    TCCR2 = 0;
+    spi_bus_ready = 1;
+}
+
+static inline void spi_configure(const spi_device_t* dev, uint8_t interrupt)
+{
+    SPCR = (1 << SPE) | (1 << MSTR) | dev->spcr | (interrupt ? (1 << SPIE) : 0);
+    SPSR = dev->spsr;
+}
+
+static inline uint8_t spi_tx_byte(const spi_transaction_t* t, uint16_t i)
+{
+    return (t->tx && i < t->tx_len) ? t->tx[i] : SPI_FILL_BYTE;
+}
+
+// Called with interrupts disabled, bus unlocked and nothing running
+static void spi_start_next(void)
+{
+    if (spi_queue_count == 0) {
+        SPCR &= ~(1 << SPIE);
+        return;
+    }
+    spi_transaction_t* t = spi_queue[spi_queue_head];
+    spi_queue_head = (spi_queue_head + 1) & (SPI_QUEUE_LEN - 1);
+    spi_queue_count--;
+
+    spi_current = t;
+    spi_pos = 0;
+    spi_configure(t->device, 1);
+    *t->device->cs_port &= ~t->device->cs_mask;
+    if (t->start) t->start(t);
+    SPDR = spi_tx_byte(t, 0);
+}
+
+static void spi_finish(spi_transaction_t* t)
+{
+    *t->device->cs_port |= t->device->cs_mask;
+    spi_current = 0;
+    t->busy = 0;
+    if (t->done) t->done(t);    // May submit follow-up transactions
+    if (!spi_current && !spi_locked) spi_start_next();
+}
+
+ISR(SPI_STC_vect)
+{
+    spi_transaction_t* t = spi_current;
+    uint8_t in = SPDR;
+    if (!t) return;
+
+    if (t->rx) t->rx[spi_pos] = in;
+    uint16_t next = ++spi_pos;
+    if (next >= t->len) {
+        spi_finish(t);
+        return;
+    }
+
+    uint8_t gap = (next == 1) ? t->device->first_gap_us : t->device->gap_us;
+    if (gap) {
+        TCNT2 = 0;
+        OCR2 = SPI_GAP_TICKS(gap);
+        TIFR = (1 << OCF2);
+        TIMSK |= (1 << OCIE2);
+        TCCR2 = (1 << WGM21) | (1 << CS21);     // CTC, fck/8
+    } else {
+        SPDR = spi_tx_byte(t, next);
+    }
+}
+
+// Inter-byte gap elapsed: clock out the next byte
+ISR(TIMER2_COMP_vect)
+{
+    TCCR2 = 0;
+    TIMSK &= ~(1 << OCIE2);
+    spi_transaction_t* t = spi_current;
+    if (t) SPDR = spi_tx_byte(t, spi_pos);
+}
+
+void spi_device_init(const spi_device_t* dev)
+{
+    spi_bus_init();
+    *dev->cs_port |= dev->cs_mask;
+    // PORTx, DDRx and PINx are consecutive: DDRx sits one below PORTx
+    *(dev->cs_port - 1) |= dev->cs_mask;
+}
+
+void spi_acquire(const spi_device_t* dev)
+{
+    for (;;) {
+        uint8_t sreg = SREG;
+        cli();
+        if (!spi_current && spi_queue_count == 0 && !spi_locked) {
+            spi_locked = 1;
+            SREG = sreg;
+            break;
+        }
+        SREG = sreg;
+    }
+    spi_configure(dev, 0);
+    *dev->cs_port &= ~dev->cs_mask;
+}
+
+void spi_release(const spi_device_t* dev)
+{
+    *dev->cs_port |= dev->cs_mask;
+    uint8_t sreg = SREG;
+    cli();
+    spi_locked = 0;
+    if (!spi_current) spi_start_next();
+    SREG = sreg;
+}
+
+uint8_t spi_submit(spi_transaction_t* t)
+{
+    uint8_t sreg = SREG;
+    cli();
+    if (spi_queue_count >= SPI_QUEUE_LEN) {
+        SREG = sreg;
+        return 0;
+    }
+    t->busy = 1;
+    spi_queue[(spi_queue_head + spi_queue_count) & (SPI_QUEUE_LEN - 1)] = t;
+    spi_queue_count++;
+    if (!spi_current && !spi_locked) spi_start_next();
+    SREG = sreg;
+    return 1;
+}
+
+uint8_t spi_idle(void)
+{
+    return !spi_current && spi_queue_count == 0;
+}
+
+void spi_wait(spi_transaction_t* t)
+{
+    while (t->busy)
+        ;
+}
+
 // SPI Setup Function (call once during initialization)
 void spi_setup(void) 
 {
@@ -27,6 +27,61 @@ void SPI_MasterTransmit(char cData); // Write byte
 char SPI_SlaveReceive(void);        // Read byte
 uint8_t SPI_Transfer(uint8_t data); // Read/write byte (full duplex)
 
+// === SPI bus manager ===
+// All SPI devices share one bus. Each driver describes its device once (chip select,
+// clock divider, SPI mode, required gaps) and then either:
+//  - runs a blocking session: spi_acquire(dev), SPI_Transfer()..., spi_release(dev)
+//  - or queues a spi_transaction_t that is clocked out from the SPI STC interrupt and
+//    reports completion through a callback.
+// Sessions wait until the queue is empty, queued transactions wait until the session
+// is released. Never call spi_acquire() from an interrupt, queue a transaction instead.
+
+// SPCR/SPSR bits for a clock divider (2, 4, 8, 16, 32, 64 or 128) and SPI mode (0-3)
+#define SPI_SPCR_BITS(div, mode) \
+    ((((mode) & 0x03) << CPHA) | \
+     (((div) == 2 || (div) == 4) ? 0 : \
+      ((div) == 8 || (div) == 16) ? (1 << SPR0) : \
+      ((div) == 32 || (div) == 64) ? (1 << SPR1) : ((1 << SPR1) | (1 << SPR0))))
+#define SPI_SPSR_BITS(div) (((div) == 2 || (div) == 8 || (div) == 32) ? (1 << SPI2X) : 0)
+
+// Device descriptor initializer, e.g. SPI_DEVICE(PORTE, PE0, 2, 0, 0, 0)
+#define SPI_DEVICE(port, pin, div, mode, first_gap, gap) \
+    { &(port), (1 << (pin)), SPI_SPCR_BITS(div, mode), SPI_SPSR_BITS(div), (first_gap), (gap) }
+
+typedef struct {
+    volatile uint8_t* cs_port;  // PORTx register of the chip select pin (active low)
+    uint8_t cs_mask;            // Chip select bit in cs_port
+    uint8_t spcr;               // CPOL/CPHA/SPR bits, see SPI_SPCR_BITS
+    uint8_t spsr;               // SPI2X bit, see SPI_SPSR_BITS
+    uint8_t first_gap_us;       // Minimum gap after the first byte (command -> data)
+    uint8_t gap_us;             // Minimum gap between the following bytes
+} spi_device_t;
+
+typedef struct spi_transaction spi_transaction_t;
+typedef void (*spi_callback_t)(spi_transaction_t* t);
+
+struct spi_transaction {
+    const spi_device_t* device;
+    const uint8_t* tx;          // First tx_len bytes sent, NULL sends SPI_FILL_BYTE only
+    uint8_t* rx;                // Received bytes (len of them), NULL discards
+    uint8_t tx_len;             // Bytes taken from tx, the rest of len is SPI_FILL_BYTE
+    uint16_t len;               // Total number of bytes clocked
+    spi_callback_t start;       // Optional, called (in ISR) right after CS goes low
+    spi_callback_t done;        // Optional, called (in ISR) right after CS goes high
+    void* context;              // Free for the owner of the transaction
+    volatile uint8_t busy;      // 1 from spi_submit() until done has been called
+};
+
+#define SPI_FILL_BYTE   0x00
+#define SPI_QUEUE_LEN   8       // Max queued transactions (power of two)
+
+void spi_device_init(const spi_device_t* dev);  // Set up CS pin (deselected) and the bus
+void spi_acquire(const spi_device_t* dev);      // Start a blocking session (CS low)
+void spi_release(const spi_device_t* dev);      // End the session (CS high), resume queue
+uint8_t spi_submit(spi_transaction_t* t);       // Queue a transaction, 0 if queue full
+uint8_t spi_idle(void);                         // 1 when nothing is queued or running
+void spi_wait(spi_transaction_t* t);            // Spin until a transaction is done
+
 // === Test functions ===
 void spi_setup(void);  // SPI test setup (call once)
 void spi_loop(void);   // SPI test loop (call repeatedly)
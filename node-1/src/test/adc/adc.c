@@ -9,14 +9,12 @@ void adc_test_setup(void)
 
 void adc_test_loop(void)
 {
-    int adc0_value = adc_read(0); // Read from ADC channel 0
-    int adc1_value = adc_read(1); // Read from ADC channel 1
-    int adc2_value = adc_read(2); // Read from ADC channel 2
-    int adc3_value = adc_read(3); // Read from ADC channel 3
+    uint8_t adc[ADC_CHANNELS];
+    adc_read_all(adc);  // One conversion for all four channels
 
-    printf_P(PSTR("ADC Readings - Joystick X: %03d, Joystick Y: %03d, Slider X: %03d, Slider Y: %03d\r\n"),
-           adc0_value, adc1_value,
-           adc2_value, adc3_value);
+    printf_P(PSTR("ADC Readings - Joystick X: %03d, Joystick Y: %03d, Slider X: %03d, Slider Y: %03d (BUSY timeouts: %u)\r\n"),
+           adc[0], adc[1],
+           adc[2], adc[3], adc_busy_timeouts());
 
     _delay_ms(10);
 }
@@ -1,6 +1,8 @@
 #include "can.h"
 #include "joystick/joystick.h"
+#include "joystick_tx/joystick_tx.h"
 #include "adc/adc.h"
+#include "tlog.h"
 
 void can_test_setup(void) 
 {
@@ -296,6 +298,102 @@ void test_can_loopback_continuous(void) {
     _delay_ms(100);  // 100ms between tests for readability
 }
 
+// === Loopback throughput benchmark ===
+#define CAN_BENCH_FRAMES 200
+
+// Old register-at-a-time transport, kept here for comparison only
+static void can_bench_send_per_register(const can_message_t* msg) {
+    mcp2515_read(MCP_TXB0CTRL);
+    mcp2515_write(0x31, (msg->id >> 3) & 0xFF);
+    mcp2515_write(0x32, (msg->id << 5) & 0xE0);
+    mcp2515_write(0x33, 0x00);
+    mcp2515_write(0x34, 0x00);
+    mcp2515_write(0x35, msg->length & 0x0F);
+    for (uint8_t i = 0; i < msg->length; i++) {
+        mcp2515_write(0x36 + i, msg->data[i]);
+    }
+    mcp2515_bit_modify(MCP_CANINTF, 0x1C, 0x00);
+    mcp2515_request_to_send(MCP_RTS_TX0);
+}
+
+static void can_bench_receive_per_register(can_message_t* msg) {
+    mcp2515_read(MCP_CANINTF);
+    uint8_t sidh = mcp2515_read(MCP_RXB0SIDH + 0);
+    uint8_t sidl = mcp2515_read(MCP_RXB0SIDH + 1);
+    msg->length = mcp2515_read(MCP_RXB0SIDH + 4) & 0x0F;
+    msg->id = ((uint16_t)sidh << 3) | ((sidl >> 5) & 0x07);
+    for (uint8_t i = 0; i < msg->length && i < 8; i++) {
+        msg->data[i] = mcp2515_read(MCP_RXB0SIDH + 5 + i);
+    }
+    mcp2515_bit_modify(MCP_CANINTF, MCP_RX0IF, 0x00);
+}
+
+// Sends CAN_BENCH_FRAMES 8-byte frames through loopback, one at a time.
+// Reports frames/s (bus time included) and the time spent in the send/receive calls.
+static void can_bench_run(const char* name, uint8_t burst) {
+    can_message_t tx = { .id = 0x155, .length = 8, .data = {1, 2, 3, 4, 5, 6, 7, 8} };
+    can_message_t rx;
+    long spi_us = 0;
+    uint16_t ok = 0;
+    
+    long start = cpu_time_microseconds();
+    for (uint16_t i = 0; i < CAN_BENCH_FRAMES; i++) {
+        tx.data[0] = i;
+        
+        long t0 = cpu_time_microseconds();
+        if (burst) {
+            can_send_message(&tx);
+        } else {
+            can_bench_send_per_register(&tx);
+        }
+        spi_us += cpu_time_microseconds() - t0;
+        
+        // Wait for the frame to loop back (about 1 ms on the bus at 125 kbps).
+        // The burst path is drained by the INT0 chain, the old one is polled.
+        uint16_t timeout = 5000;
+        if (burst) {
+            while (!can_message_pending() && --timeout)
+                ;
+        } else {
+            while (!(mcp2515_read_status() & MCP_STAT_RX0IF) && --timeout)
+                ;
+        }
+        
+        t0 = cpu_time_microseconds();
+        if (burst) {
+            can_receive_message(&rx);
+        } else {
+            can_bench_receive_per_register(&rx);
+        }
+        spi_us += cpu_time_microseconds() - t0;
+        
+        if (timeout && rx.id == tx.id && rx.data[0] == tx.data[0]) ok++;
+    }
+    long elapsed = cpu_time_microseconds() - start;
+    
+    uint32_t fps = (uint32_t)CAN_BENCH_FRAMES * 1000000UL / (uint32_t)elapsed;
+    printf_P(PSTR("%-12S %4lu frames/s  calls %4ld us/frame  ok %u/%u\r\n"),
+             name, fps, spi_us / CAN_BENCH_FRAMES, ok, CAN_BENCH_FRAMES);
+}
+
+void can_loopback_benchmark(void) {
+    printf_P(PSTR("\r\n=== CAN loopback benchmark (%d x 8 byte frames) ===\r\n"), CAN_BENCH_FRAMES);
+    cpu_time_init();
+    can_init();
+    
+    // CAN interrupts off so the polled run does not race the INT0 chain
+    mcp2515_write(MCP_CANINTE, MCP_NO_INT);
+    can_bench_run(PSTR("per-register"), 0);
+    mcp2515_write(MCP_CANINTE, MCP_RX_INT | MCP_TX_INT);
+    can_bench_run(PSTR("burst"), 1);
+    
+    // SPI bytes per frame, send + receive (8 data bytes). Burst: LOAD TX + TXBnCTRL write,
+    // then READ STATUS + READ from RXBnCTRL + one BITMOD for the flags (shared with TXnIF)
+    printf_P(PSTR("SPI bytes/frame: per-register %d, burst %d\r\n"),
+             (3 + 5 * 3 + 8 * 3 + 4 + 1) + (3 + 3 * 3 + 8 * 3 + 4),
+             (1 + MCP_FRAME_MAX_LEN + 3) + (2 + 3 + MCP_FRAME_MAX_LEN + 4));
+}
+
 static uint8_t mcp2515_test_run = 0;
 static uint8_t can_test_run = 0;
 static uint8_t can_unit_test_run = 0;
@@ -397,7 +495,7 @@ void can_test_loop_node2(void)
         mcp2515_test_run = 1;
         
         // Initialize CAN in NORMAL mode for real CAN bus
-        printf_P(PSTR("Initializing CAN in NORMAL mode (250 kbps)...\r\n"));
+        printf_P(PSTR("Initializing CAN in NORMAL mode (%lu kbps)...\r\n"), CAN_BITRATE / 1000);
         can_init_normal();
         
         // Verify mode
@@ -440,27 +538,25 @@ void can_test_loop_node2(void)
  */
 void send_joystick_over_can(void) {
     // Read current joystick position
-    joystick_pos_t joystick = joystick_get_position();
-    slider_pos_t slider = slider_get_position();
+    joystick_pos_t joystick;
+    slider_pos_t slider;
+    joystick_read_inputs(&joystick, &slider);
     
-    // Create CAN message with joystick data
+    // Joystick frame, layout in common/protocol.h
     can_message_t joystick_msg = {
-        .id = 0x00,         // Joystick data message ID (Node 2 expects 0x00!)
-        .length = 5,        // 5 bytes: joy_x, joy_y, joy_btn, slider_x, slider_y
-        .data = {
-            joystick.x,      // Joystick X (0-100%)
-            joystick.y,      // Joystick Y (0-100%)  
-            joystick.button, // Button state (0/1)
-            slider.x,        // Slider X (0-255)
-            slider.y         // Slider Y (0-255)
-        }
+        PROTO_MSG(PROTO_ID_JOYSTICK, proto_joystick_t,
+            .x = joystick.x,
+            .y = joystick.y,
+            .button = joystick.button,
+            .slider_x = slider.x,
+            .slider_y = slider.y)
     };
     
     // Send joystick data to Node 2
-    if (can_send_message(&joystick_msg)) {
+    if (can_send_message_priority(&joystick_msg, CAN_PRIO_CONTROL)) {
         // Success - no printf to avoid slowing down transmission
     } else {
-        printf_P(PSTR("JOY->Node2: Send failed ✗\r\n"));
+        TLOG("JOY->Node2: Send failed (x=%u y=%u)\n", joystick.x, joystick.y);
     }
 }
 
@@ -470,7 +566,7 @@ void send_joystick_over_can(void) {
  */
 void test_joystick_can_communication(void) {
     static uint32_t message_count = 0;
-    static uint8_t send_delay = 0;
+    static long last_report = 0;
     static bool joystick_can_initialized = false;
     
     // Initialize CAN for normal mode once (same as can_test_loop_node2)
@@ -481,7 +577,7 @@ void test_joystick_can_communication(void) {
         test_mcp2515();
         
         // Initialize CAN in NORMAL mode for real CAN bus
-        printf_P(PSTR("Initializing CAN in NORMAL mode (125 kbps)...\r\n"));
+        printf_P(PSTR("Initializing CAN in NORMAL mode (%lu kbps)...\r\n"), CAN_BITRATE / 1000);
         can_init_normal();
         
         // Verify mode
@@ -494,18 +590,33 @@ void test_joystick_can_communication(void) {
             printf_P(PSTR("ERROR (0x%02X)\r\n"), mode);
         }
         
+        cpu_time_init();
+        joystick_tx_init();
+        last_report = cpu_time_milliseconds();
+        
         printf_P(PSTR("Joystick CAN ready!\r\n"));
         printf_P(PSTR("Move joystick and slider to see real-time data\r\n\r\n"));
         joystick_can_initialized = true;
         return;
     }
     
-    // Send joystick data as fast as possible for responsive servo control
-    message_count++;
-    
-    // Send actual joystick data (no printf to avoid slowing down)
-    send_joystick_over_can();
+    // Change-driven: up to 200Hz while the stick moves, heartbeat while idle
+    joystick_pos_t joystick;
+    slider_pos_t slider;
+    joystick_read_inputs(&joystick, &slider);
+    if (joystick_tx_update(joystick, slider, 0)) {
+        message_count++;
+    }
     
-    // Minimal delay for reasonable update rate (~50Hz = 20ms)
-    _delay_ms(20);
+    // Frame rate every 5s, compare with the old fixed 50Hz
+    long now = cpu_time_milliseconds();
+    if (now - last_report >= 5000) {
+        joystick_tx_stats_t stats;
+        joystick_tx_stats(0, &stats);
+        printf_P(PSTR("JOY TX: %lu frames, %u moves, %u heartbeats, %u held (fixed rate would be 250)\r\n"),
+                 message_count, stats.changes, stats.heartbeats, stats.suppressed);
+        joystick_tx_stats_reset();
+        message_count = 0;
+        last_report = now;
+    }
 }
\ No newline at end of file
@@ -24,6 +24,7 @@ void can_test_loop(void);
 void can_test_loop_continuous(void);
 void can_test_loop_node2(void);           // Test Node 1 <-> Node 2 communication
 void test_can_loopback_continuous(void);
+void can_loopback_benchmark(void);        // Frames/s through loopback, per-register vs burst
 
 // Checkpoint #8: Joystick over CAN functions
 void send_joystick_over_can(void);        // Send single joystick reading
@@ -6,12 +6,19 @@
 #include "game_menu.h"
 #include "../../oled/oled.h"
 #include "../../joystick/joystick.h"
+#include "../../adc/adc.h"
 #include "../../mcp2515/mcp2515.h"
 #include "../../can/can.h"
+#include "../../cpu_time/cpu_time.h"
+#include "../../joystick_tx/joystick_tx.h"
+#include "../../can_stats/can_stats.h"
+#include "../../profile/profile.h"
+#include "../../sched/sched.h"
+#include "../../ioboard/ioboard.h"
 #include <stdio.h>
 #include <stdbool.h>
 #include <stdint.h>
-#include <util/delay.h>
+#include <avr/pgmspace.h>
 
 typedef enum {
     MENU_START_GAME,
@@ -30,15 +37,76 @@ static display_state_t display_state = STATE_MENU;
 static uint32_t high_scores[5] = {0, 0, 0, 0, 0};
 static bool display_needs_update = true;
 
-void game_menu_init(void) {
-    oled_init();
-    mcp2515_init();
-    can_init_normal();
+// Node 1 only listens for the game-over frame and the diagnostics from Node 2
+static const can_filter_t game_menu_can_filters[] = {
+    { .id = PROTO_ID_GAME_OVER, .mask = 0x7FF, .urgent = 1 },    // Game over -> RXB0
+    { .id = PROTO_ID_DIAG_NODE2, .mask = 0x7FF, .urgent = 0 },   // Diagnostics -> RXB1
+};
+
+// Insert a finished round into the descending high score table
+static void record_high_score(uint32_t score) {
+    for (uint8_t i = 0; i < 5; i++) {
+        if (score > high_scores[i]) {
+            for (uint8_t j = 4; j > i; j--) {
+                high_scores[j] = high_scores[j - 1];
+            }
+            high_scores[i] = score;
+            return;
+        }
+    }
 }
 
-void game_menu_loop(void) {
-    // Read joystick
+// Joystick frame rate per screen, printed when a game ends
+static void game_menu_report_tx(void) {
+    static const char names[][8] PROGMEM = {"menu", "playing", "scores"};
+    for (uint8_t i = 0; i < 3; i++) {
+        joystick_tx_stats_t stats;
+        joystick_tx_stats(i, &stats);
+        uint32_t frames = (uint32_t)stats.changes + stats.heartbeats;
+        uint32_t rate = stats.time_ms ? frames * 1000UL / stats.time_ms : 0;
+        printf_P(PSTR("JOY TX %-7S %3lu frames/s (%u moves, %u heartbeats, %u held, %u failed)\r\n"),
+                 names[i], rate, stats.changes, stats.heartbeats, stats.suppressed, stats.failed);
+    }
+}
+
+// Task rates (ms). Input and CAN TX share the 200 Hz slot so every frame carries
+// the sample taken just before it (same priority runs in the order added).
+#define GAME_MENU_INPUT_MS      5
+#define GAME_MENU_CAN_TX_MS     5
+#define GAME_MENU_CAN_RX_MS     2
+#define GAME_MENU_DISPLAY_MS    50
+#define GAME_MENU_SERVICE_MS    50
+
+static const char game_menu_task_names[][8] PROGMEM = {
+    "input", "can tx", "can rx", "display", "service", "ioboard"
+};
+
+// Latest joystick sample, written by the input task
+static joystick_pos_t game_joy;
+
+// Drain received frames in every state so diagnostics never pile up in the ring
+static void game_menu_task_can_rx(void) {
+    can_message_t rx;
+    while (can_receive_message(&rx)) {
+        if (display_state == STATE_PLAYING && PROTO_IS(rx, PROTO_ID_GAME_OVER, proto_game_over_t)) {
+            // Game over received from Node 2
+            record_high_score(PROTO_DECODE(proto_game_over_t, rx).score);
+            game_menu_report_tx();
+            display_state = STATE_MENU;
+            display_needs_update = true;
+        } else {
+            can_stats_peer_frame(&rx);
+        }
+    }
+}
+
+// Sample the joystick and run the menu state machine
+static void game_menu_task_input(void) {
     joystick_pos_t joy = joystick_get_position();
+    game_joy = joy;
+    
+    // The I/O board nav button selects too (cached by the ioboard task, no SPI here)
+    bool button = joy.button || (ioboard_get_buttons().nav & IOBOARD_NAV_BTN);
     
     // State-based behavior
     if (display_state == STATE_MENU) {
@@ -57,7 +125,7 @@ void game_menu_loop(void) {
         
         // Button press
         static bool last_button = false;
-        if (joy.button && !last_button) {  // Rising edge detection
+        if (button && !last_button) {  // Rising edge detection
             if (selected_option == MENU_HIGH_SCORES) {
                 display_state = STATE_HIGH_SCORES;
                 display_needs_update = true;
@@ -66,82 +134,106 @@ void game_menu_loop(void) {
                 display_needs_update = true;
             }
         }
-        last_button = joy.button;
+        last_button = button;
         
     } else if (display_state == STATE_HIGH_SCORES) {
         // Button press to go back
         static bool last_button_hs = false;
-        if (joy.button && !last_button_hs) {
+        if (button && !last_button_hs) {
             display_state = STATE_MENU;
             display_needs_update = true;
         }
-        last_button_hs = joy.button;
+        last_button_hs = button;
         
     } else if (display_state == STATE_PLAYING) {
         // In playing state: DON'T consume button presses
         // Just pass joystick data through to Node 2 via CAN
         // Node 2 will handle the button for solenoid firing
         
-        // Check for game over message from Node 2 (CAN ID 0x01)
-        can_message_t game_over_msg;
-        if (can_receive_message(&game_over_msg)) {
-            if (game_over_msg.id == 0x01 && game_over_msg.data[0] == 0xFF) {
-                // Game over received from Node 2
-                display_state = STATE_MENU;
-                display_needs_update = true;
-            }
-        }
-        
-        // Only exit on beam break (game over message from Node 2)
+        // Only exit on beam break (game over message from Node 2, see above)
         // No manual escape with joystick position
     }
+}
+
+// Joystick goes to Node 2 in every state (Node 2 starts the game on the
+// button), but only when it moves or the heartbeat is due
+static void game_menu_task_can_tx(void) {
+    joystick_tx_update(game_joy, (slider_pos_t){0}, display_state);
+}
+
+// Only update display when needed
+static void game_menu_task_display(void) {
+    if (!display_needs_update || oled_flush_busy()) {
+        return;
+    }
+    oled_clear_screen();
     
-    // Only update display when needed
-    if (display_needs_update) {
-        oled_clear_screen();
+    if (display_state == STATE_HIGH_SCORES) {
+        oled_print_string("HIGH SCORES", 0, 0);
         
-        if (display_state == STATE_HIGH_SCORES) {
-            oled_print_string("HIGH SCORES", 0, 0);
-            
-            for (int i = 0; i < 5; i++) {
-                char buf[16];
-                snprintf(buf, sizeof(buf), "%d. %lu", i+1, high_scores[i]);
-                oled_print_string(buf, 0, (i+1)*8);
-            }
-            
-            oled_print_string("BTN=Back", 0, 56);
-            
-        } else if (display_state == STATE_PLAYING) {
-            oled_print_string("GAME PLAYING", 20, 10);
-            oled_print_string("- - - - -", 30, 25);
-            oled_print_string("Control with", 15, 35);
-            oled_print_string("joystick!", 25, 45);
-            
-        } else {  // STATE_MENU
-            if (selected_option == MENU_START_GAME) {
-                oled_print_string("> START GAME", 10, 20);
-                oled_print_string("  HIGH SCORES", 10, 35);
-            } else {
-                oled_print_string("  START GAME", 10, 20);
-                oled_print_string("> HIGH SCORES", 10, 35);
-            }
-            
-            oled_print_string("Move X, Press BTN", 0, 56);
+        for (int i = 0; i < 5; i++) {
+            char buf[16];
+            snprintf(buf, sizeof(buf), "%d. %lu", i+1, high_scores[i]);
+            oled_print_string(buf, 0, (i+1)*8);
         }
         
-        display_needs_update = false;
+        oled_print_string("BTN=Back", 0, 56);
+        
+    } else if (display_state == STATE_PLAYING) {
+        oled_print_string("GAME PLAYING", 20, 10);
+        oled_print_string("- - - - -", 30, 25);
+        oled_print_string("Control with", 15, 35);
+        oled_print_string("joystick!", 25, 45);
+        
+    } else {  // STATE_MENU
+        if (selected_option == MENU_START_GAME) {
+            oled_print_string("> START GAME", 10, 20);
+            oled_print_string("  HIGH SCORES", 10, 35);
+        } else {
+            oled_print_string("  START GAME", 10, 20);
+            oled_print_string("> HIGH SCORES", 10, 35);
+        }
+        
+        oled_print_string("Move X, Press BTN", 0, 56);
     }
     
-    // Send CAN data at controlled rate (20ms = 50Hz)
-    can_message_t msg;
-    msg.id = 0x00;
-    msg.length = 5;
-    msg.data[0] = joy.x;
-    msg.data[1] = joy.y;
-    msg.data[2] = joy.button;
-    msg.data[3] = 0; // slider_left
-    msg.data[4] = 0; // slider_right
-    can_send_message(&msg);
+    oled_flush_async();  // Only changed columns go out over SPI, in the background
+    display_needs_update = false;
+}
+
+static void game_menu_task_service(void) {
+    // Bus health: diagnostics frame once a second
+    can_stats_service();
+    
+    // Reports on demand: 's' CAN counters, 'p' profile table, 't' task table, 'm' memory
+    switch (uart_read()) {
+        case CAN_STATS_QUERY: can_stats_print(); break;
+        case PROFILE_QUERY:   profile_dump();    break;
+        case SCHED_QUERY:     sched_print();     break;
+        case XMEM_QUERY:      xmem_report();     break;
+    }
+}
+
+void game_menu_init(void) {
+    oled_init();
+    mcp2515_init();
+    can_init_normal();
+    can_set_filters(game_menu_can_filters, sizeof(game_menu_can_filters) / sizeof(game_menu_can_filters[0]));
+    cpu_time_init();
+    adc_sampler_start();    // Joystick/slider reads become filtered snapshots
+    profile_init();
+    joystick_tx_init();
+    ioboard_init();
     
-    _delay_ms(20);  // 50Hz update rate
+    sched_init();
+    sched_add(game_menu_task_input, GAME_MENU_INPUT_MS, 0, SCHED_PRIO_CONTROL, game_menu_task_names[0]);
+    sched_add(game_menu_task_can_tx, GAME_MENU_CAN_TX_MS, 0, SCHED_PRIO_CONTROL, game_menu_task_names[1]);
+    sched_add(game_menu_task_can_rx, GAME_MENU_CAN_RX_MS, 1, SCHED_PRIO_CONTROL, game_menu_task_names[2]);
+    sched_add(game_menu_task_display, GAME_MENU_DISPLAY_MS, 3, SCHED_PRIO_DISPLAY, game_menu_task_names[3]);
+    sched_add(game_menu_task_service, GAME_MENU_SERVICE_MS, 7, SCHED_PRIO_LOW, game_menu_task_names[4]);
+    sched_add(ioboard_service, IOBOARD_POLL_MS, 2, SCHED_PRIO_INPUT, game_menu_task_names[5]);
+}
+
+void game_menu_loop(void) {
+    sched_run();
 }
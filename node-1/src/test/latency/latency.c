@@ -0,0 +1,143 @@
+#include "latency.h"
+#include "adc/adc.h"
+#include "mcp2515/mcp2515.h"
+#include "protocol.h"
+#include <util/delay.h>
+
+// Round trips per report
+#define LATENCY_SAMPLES         500
+
+// Give up on an echo after this long
+#define LATENCY_TIMEOUT_US      50000L
+
+// Pause between pings so Node 2 is not flooded
+#define LATENCY_GAP_MS          10
+
+// Histogram: LATENCY_BUCKETS buckets of LATENCY_BUCKET_US, the last one collects everything above
+#define LATENCY_BUCKET_US       200     // 25.6 ms range: the echo waits for Node 2's 20 ms PI step
+#define LATENCY_BUCKETS         128
+
+static uint16_t latency_hist[LATENCY_BUCKETS];
+static uint32_t latency_min_us;
+static uint32_t latency_max_us;
+static uint32_t latency_service_sum_us;     // Node 2 reception -> motor command
+static uint16_t latency_count;
+static uint16_t latency_lost;
+
+// Only echoes from Node 2 are needed
+static const can_filter_t latency_can_filters[] = {
+    { .id = PROTO_ID_LATENCY_ECHO, .mask = 0x7FF, .urgent = 1 },
+};
+
+static void latency_reset(void)
+{
+    for (uint8_t i = 0; i < LATENCY_BUCKETS; i++) {
+        latency_hist[i] = 0;
+    }
+    latency_min_us = UINT32_MAX;
+    latency_max_us = 0;
+    latency_service_sum_us = 0;
+    latency_count = 0;
+    latency_lost = 0;
+}
+
+static void latency_record(uint32_t rtt_us, uint16_t service_us)
+{
+    uint32_t bucket = rtt_us / LATENCY_BUCKET_US;
+    latency_hist[bucket < LATENCY_BUCKETS ? bucket : LATENCY_BUCKETS - 1]++;
+    if (rtt_us < latency_min_us) latency_min_us = rtt_us;
+    if (rtt_us > latency_max_us) latency_max_us = rtt_us;
+    latency_service_sum_us += service_us;
+    latency_count++;
+}
+
+// Upper edge of the bucket holding the given percentile (max if it is in the overflow bucket)
+static uint32_t latency_percentile(uint8_t percent)
+{
+    uint32_t rank = ((uint32_t)latency_count * percent + 99) / 100;
+    uint32_t seen = 0;
+    for (uint8_t i = 0; i < LATENCY_BUCKETS - 1; i++) {
+        seen += latency_hist[i];
+        if (seen >= rank) {
+            return (uint32_t)(i + 1) * LATENCY_BUCKET_US;
+        }
+    }
+    return latency_max_us;
+}
+
+static void latency_report(void)
+{
+    printf_P(PSTR("\r\n=== Joystick -> Node 2 round trip (%u ok, %u lost) ===\r\n"),
+             latency_count, latency_lost);
+    if (latency_count == 0) {
+        printf_P(PSTR("No echoes - is Node 2 in the play loop?\r\n"));
+        return;
+    }
+    printf_P(PSTR("min %lu us  p50 <%lu us  p99 <%lu us  max %lu us\r\n"),
+             latency_min_us, latency_percentile(50), latency_percentile(99), latency_max_us);
+    printf_P(PSTR("Node 2 rx -> command: %lu us avg\r\n"),
+             latency_service_sum_us / latency_count);
+
+    // Non-empty buckets only
+    for (uint8_t i = 0; i < LATENCY_BUCKETS; i++) {
+        if (latency_hist[i]) {
+            printf_P(PSTR("%5u us%c %4u\r\n"), (uint16_t)(i * LATENCY_BUCKET_US),
+                     i == LATENCY_BUCKETS - 1 ? '+' : ' ', latency_hist[i]);
+        }
+    }
+}
+
+void latency_test_setup(void)
+{
+    uart_init(MYUBRR);
+    spi_setup();
+    adc_init();
+    joystick_init();
+    cpu_time_init();
+    mcp2515_init();
+    can_init_normal();
+    can_set_filters(latency_can_filters, sizeof(latency_can_filters) / sizeof(latency_can_filters[0]));
+    latency_reset();
+    printf_P(PSTR("Latency benchmark: %d round trips per report, start a game on Node 2\r\n"),
+             LATENCY_SAMPLES);
+}
+
+void latency_test_loop(void)
+{
+    // Stamp before the ADC read so the conversion time is part of the path
+    uint32_t stamp = (uint32_t)cpu_time_microseconds();
+    joystick_pos_t joy = joystick_get_position();
+
+    can_message_t ping = {
+        PROTO_MSG(PROTO_ID_JOYSTICK_STAMPED, proto_joystick_stamped_t,
+            .x = joy.x,
+            .y = joy.y,
+            .button = joy.button,
+            .stamp_us = stamp)
+    };
+
+    uint8_t answered = 0;
+    if (can_send_message_priority(&ping, CAN_PRIO_CONTROL)) {
+        while (!answered && (uint32_t)cpu_time_microseconds() - stamp < LATENCY_TIMEOUT_US) {
+            can_message_t rx;
+            if (!can_receive_message(&rx) || !PROTO_IS(rx, PROTO_ID_LATENCY_ECHO, proto_latency_echo_t)) {
+                continue;
+            }
+            uint32_t now = (uint32_t)cpu_time_microseconds();
+            proto_latency_echo_t echo = PROTO_DECODE(proto_latency_echo_t, rx);
+            if (echo.stamp_us == stamp) {  // Late echoes of timed-out pings are dropped
+                latency_record(now - stamp, echo.service_us);
+                answered = 1;
+            }
+        }
+    }
+    if (!answered) {
+        latency_lost++;
+    }
+
+    if (latency_count + latency_lost >= LATENCY_SAMPLES) {
+        latency_report();
+        latency_reset();
+    }
+    _delay_ms(LATENCY_GAP_MS);
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <avr/pgmspace.h>
+#include "uart/uart.h"
+#include "spi/spi.h"
+#include "can/can.h"
+#include "joystick/joystick.h"
+#include "cpu_time/cpu_time.h"
+
+void latency_test_setup(void);
+void latency_test_loop(void);   // Joystick -> Node 2 actuator -> echo round trip histogram
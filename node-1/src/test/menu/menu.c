@@ -1,5 +1,7 @@
 #include "menu.h"
 
+static const char menu_test_ioboard_name[] PROGMEM = "ioboard";
+
 void menu_test_setup(void) 
 {
     // Initialize hardware
@@ -9,13 +11,16 @@ void menu_test_setup(void)
     spi_setup();
     oled_init();
     ioboard_init();
+    sched_init();
+    
+    // I/O board buttons are polled in the background, the menu reads the cache
+    sched_add(ioboard_service, IOBOARD_POLL_MS, 0, SCHED_PRIO_INPUT, menu_test_ioboard_name);
     
-    // Initial display
-    oled_clear_screen();
-    display_menu();
+    // Initial display, then navigation runs as a scheduler task
+    menu_init();
 }
 
 void menu_test_loop(void)
 {
-    menu_selector();
+    sched_run();
 }
@@ -0,0 +1,95 @@
+#include "oled.h"
+
+#define OLED_BENCH_FRAMES 20
+
+void oled_test_setup(void)
+{
+    uart_init(MYUBRR);
+    spi_setup();
+    cpu_time_init();
+    oled_init_mode(OLED_ADDR_PAGE);
+    printf_P(PSTR("OLED benchmark: %d full frames per run\r\n"), OLED_BENCH_FRAMES);
+}
+
+// Old transport: three single commands for the cursor, then one CS cycle + delay per byte
+static void oled_bench_frame_per_byte(uint8_t value)
+{
+    for (uint8_t page = 0; page < OLED_PAGES; page++) {
+        oled_write_command(OLED_SET_PAGE_ADDR + page);
+        oled_write_command(OLED_SET_COL_LOW);
+        oled_write_command(OLED_SET_COL_HIGH);
+        for (uint8_t col = 0; col < OLED_WIDTH; col++) {
+            oled_write_data(value);
+        }
+    }
+}
+
+// New transport: framebuffer flush, one cursor run + data run per page in page mode
+// and a single window + data run for the whole frame in horizontal/vertical mode
+static void oled_fb_fill_frame(uint8_t value)
+{
+    if (value) {
+        oled_fill_screen_white();
+    } else {
+        oled_clear_screen();
+    }
+    oled_invalidate();  // Force a full frame even if nothing changed
+}
+
+// Same frames through the SPI STC interrupt queue, waited for so the time is comparable
+static void oled_flush_async_wait(void)
+{
+    oled_flush_async();
+    oled_flush_wait();
+}
+
+// Transport time only: the framebuffer fill before each flush is not counted, so the
+// result compares with the per-byte baseline (which never touches the framebuffer)
+static long oled_bench_flushes(void (*flush)(void))
+{
+    long elapsed_us = 0;
+    for (uint8_t i = 0; i < OLED_BENCH_FRAMES; i++) {
+        oled_fb_fill_frame((i & 1) ? 0xFF : 0x00);
+        long start = cpu_time_microseconds();
+        flush();
+        elapsed_us += cpu_time_microseconds() - start;
+    }
+    return elapsed_us;
+}
+
+// Prints frames per second with one decimal
+static void oled_bench_report(const char* name, long elapsed_us)
+{
+    uint32_t fps_x10 = (uint32_t)OLED_BENCH_FRAMES * 10000000UL / (uint32_t)elapsed_us;
+    printf_P(PSTR("%-10S %7ld us  %3lu.%lu frames/s\r\n"),
+             name, elapsed_us, fps_x10 / 10, fps_x10 % 10);
+}
+
+void oled_test_loop(void)
+{
+    oled_set_addr_mode(OLED_ADDR_PAGE);
+    long start = cpu_time_microseconds();
+    for (uint8_t i = 0; i < OLED_BENCH_FRAMES; i++) {
+        oled_bench_frame_per_byte((i & 1) ? 0xFF : 0x00);
+    }
+    oled_bench_report(PSTR("per-byte"), cpu_time_microseconds() - start);
+
+    oled_bench_report(PSTR("streaming"), oled_bench_flushes(oled_flush));
+
+    oled_set_addr_mode(OLED_ADDR_HORIZONTAL);
+    oled_bench_report(PSTR("window"), oled_bench_flushes(oled_flush));
+    oled_bench_report(PSTR("async"), oled_bench_flushes(oled_flush_async_wait));
+
+    // Cost of drawing a full frame into the external SRAM framebuffer, for reference
+    start = cpu_time_microseconds();
+    for (uint8_t i = 0; i < OLED_BENCH_FRAMES; i++) {
+        oled_fb_fill_frame((i & 1) ? 0xFF : 0x00);
+    }
+    oled_bench_report(PSTR("fb fill"), cpu_time_microseconds() - start);
+
+    // Per-byte frames bypass the framebuffer, so resync the display with it
+    oled_clear_screen();
+    oled_invalidate();
+    oled_flush();
+    _delay_ms(1000);
+}
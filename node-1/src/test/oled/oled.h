@@ -0,0 +1,10 @@
+#pragma once
+
+#include <avr/pgmspace.h>
+#include "uart/uart.h"
+#include "spi/spi.h"
+#include "oled/oled.h"
+#include "cpu_time/cpu_time.h"
+
+void oled_test_setup(void);
+void oled_test_loop(void);   // Full-frame write benchmark: per-byte vs streaming vs window
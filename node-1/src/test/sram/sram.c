@@ -1,51 +1,256 @@
 #include "sram.h"
+#include <string.h>
+#include <util/delay.h>
 
-void sram_test_setup(void)
+/*
+ * Destructive: overwrites the whole external SRAM (framebuffer, mapping
+ * tables, XMEM_SECTION buffers), so run it as its own test program.
+ */
+
+// Walking ones over A0..A10 inside the 2 KiB block at 0x1800 (0x1800 ^ 0x800 would be the ADC)
+#define SRAM_ADDR_BASE          0x1800
+#define SRAM_ADDR_SPAN          0x800
+
+// The NAND decoder selects the SRAM for A11:A10 = 01, 10, 11 and the ADC for 00
+#define SRAM_BLOCK_SIZE         0x400
+#define SRAM_ALIAS_STEP         0x40    // Offsets checked in every block
+
+// Bandwidth: bytes per run, internal SRAM reference buffer (on the stack)
+#define SRAM_BENCH_BYTES        1024
+#define SRAM_BENCH_INTERNAL     128
+
+#define SRAM_REPORT_GAP_MS      2000
+
+typedef struct {
+    uint16_t errors;
+    uint16_t first_addr;        // First failure, for the summary
+    uint8_t expected;
+    uint8_t actual;
+} sram_result_t;
+
+static volatile uint8_t* const sram_blocks[] = {
+    (volatile uint8_t*)0x1400, (volatile uint8_t*)0x1800, (volatile uint8_t*)0x1C00
+};
+#define SRAM_BLOCKS (sizeof(sram_blocks) / sizeof(sram_blocks[0]))
+
+static volatile uint8_t sram_sink;
+
+static void sram_check(sram_result_t* r, volatile uint8_t* p, uint8_t expected)
 {
-    xmem_init();
-    uart_init(MYUBRR);
-    printf_P(PSTR("Startup OK\r\n"));
+    uint8_t actual = *p;
+    if (actual != expected) {
+        if (r->errors == 0) {
+            r->first_addr = (uint16_t)(uintptr_t)p;
+            r->expected = expected;
+            r->actual = actual;
+        }
+        r->errors++;
+    }
 }
 
-void sram_test_loop(void)
+// Every data line alone high, then alone low, at one address
+static void sram_data_bus(sram_result_t* r)
+{
+    volatile uint8_t* p = (volatile uint8_t*)XMEM_SRAM_START;
+    for (uint8_t bit = 1; bit; bit <<= 1) {
+        *p = bit;
+        sram_check(r, p, bit);
+        *p = ~bit;
+        sram_check(r, p, (uint8_t)~bit);
+    }
+}
+
+// Power-of-two offsets: finds address lines stuck high, stuck low or shorted together
+static void sram_address_bus(sram_result_t* r)
+{
+    volatile uint8_t* base = (volatile uint8_t*)SRAM_ADDR_BASE;
+
+    for (uint16_t off = 1; off < SRAM_ADDR_SPAN; off <<= 1) {
+        base[off] = 0xAA;
+    }
+
+    // Stuck high: writing the base must not reach any other offset
+    base[0] = 0x55;
+    for (uint16_t off = 1; off < SRAM_ADDR_SPAN; off <<= 1) {
+        sram_check(r, &base[off], 0xAA);
+    }
+    base[0] = 0xAA;
+
+    // Stuck low or shorted: writing one offset must not reach the base or another one
+    for (uint16_t test = 1; test < SRAM_ADDR_SPAN; test <<= 1) {
+        base[test] = 0x55;
+        sram_check(r, &base[0], 0xAA);
+        for (uint16_t off = 1; off < SRAM_ADDR_SPAN; off <<= 1) {
+            if (off != test) {
+                sram_check(r, &base[off], 0xAA);
+            }
+        }
+        base[test] = 0xAA;
+    }
+}
+
+// Signature of block b at offset off, different for every block and offset step
+static uint8_t sram_signature(uint8_t b, uint16_t off)
+{
+    return (uint8_t)(off / SRAM_ALIAS_STEP) ^ (0x33 * (b + 1));
+}
+
+// The three SRAM blocks must be distinct (A10/A11 reach the chip), and a write
+// to the ADC window (A11:A10 = 00) must not land in any of them
+static void sram_aliasing(sram_result_t* r)
 {
-    volatile char *ext_ram = (char *)0x1800; // Start address for the SRAM
-    uint16_t ext_ram_size = 0x800;
-    uint16_t write_errors = 0;
-    uint16_t retrieval_errors = 0;
-    printf_P(PSTR("Starting SRAM test...\r\n"));
-    // rand() stores some internal state, so calling this function in a loop will
-    // yield different seeds each time (unless srand() is called before this function)
-    uint16_t seed = rand();
-    // Write phase: Immediately check that the correct value was stored
-    srand(seed);
-    for (uint16_t i = 0; i < ext_ram_size; i++)
-    {
-        uint8_t some_value = rand();
-        ext_ram[i] = some_value;
-        uint8_t retreived_value = ext_ram[i];
-        if (retreived_value != some_value)
-        {
-            printf_P(PSTR("Write phase error: ext_ram[%4d] = %02X (should be %02X)\r\n"), i, retreived_value, some_value);
-            write_errors++;
+    for (uint16_t off = 0; off < SRAM_BLOCK_SIZE; off += SRAM_ALIAS_STEP) {
+        for (uint8_t b = 0; b < SRAM_BLOCKS; b++) {
+            sram_blocks[b][off] = sram_signature(b, off);
         }
-        else
-        {
-            printf_P(PSTR("ext_ram[%4d] = %02X\r\n"), i, retreived_value);
+        for (uint8_t b = 0; b < SRAM_BLOCKS; b++) {
+            sram_check(r, &sram_blocks[b][off], sram_signature(b, off));
+        }
+
+        ((volatile uint8_t*)XMEM_ADC_ADDR)[off] = 0;     // Starts a MAX156 conversion, like adc_read_all
+        _delay_us(ADC_BUSY_TIMEOUT_US);
+        for (uint8_t b = 0; b < SRAM_BLOCKS; b++) {
+            sram_check(r, &sram_blocks[b][off], sram_signature(b, off));
+        }
+    }
+}
+
+// March C-: up(w0); up(r0,w1); up(r1,w0); down(r0,w1); down(r1,w0); up(r0)
+// Finds stuck-at, transition and coupling faults between cells
+static void sram_march_c(sram_result_t* r)
+{
+    volatile uint8_t* const ram = (volatile uint8_t*)XMEM_SRAM_START;
+    const uint16_t n = XMEM_SRAM_SIZE;
+    uint16_t i;
+
+    for (i = 0; i < n; i++) {
+        ram[i] = 0x00;
+    }
+    for (i = 0; i < n; i++) {
+        sram_check(r, &ram[i], 0x00);
+        ram[i] = 0xFF;
+    }
+    for (i = 0; i < n; i++) {
+        sram_check(r, &ram[i], 0xFF);
+        ram[i] = 0x00;
+    }
+    for (i = n; i-- > 0;) {
+        sram_check(r, &ram[i], 0x00);
+        ram[i] = 0xFF;
+    }
+    for (i = n; i-- > 0;) {
+        sram_check(r, &ram[i], 0xFF);
+        ram[i] = 0x00;
+    }
+    for (i = 0; i < n; i++) {
+        sram_check(r, &ram[i], 0x00);
+    }
+}
+
+static void sram_print_result(PGM_P name, const sram_result_t* r)
+{
+    printf_P(name);
+    if (r->errors == 0) {
+        printf_P(PSTR("ok\r\n"));
+    } else {
+        printf_P(PSTR("%u errors, first at 0x%04X: read 0x%02X, expected 0x%02X\r\n"),
+                 r->errors, r->first_addr, r->actual, r->expected);
+    }
+}
+
+// === Bandwidth ===
+
+static cpu_ticks_t sram_time_read(const volatile uint8_t* p, uint16_t n, uint8_t repeat)
+{
+    cpu_ticks_t start = cpu_time_ticks();
+    uint8_t sum = 0;
+    while (repeat--) {
+        for (uint16_t i = 0; i < n; i++) {
+            sum += p[i];
         }
     }
-    // Retrieval phase: Check that no values were changed during or after the write phase
-    srand(seed);
-    // reset the PRNG to the state it had before the write phase
-    for (uint16_t i = 0; i < ext_ram_size; i++)
-    {
-        uint8_t some_value = rand();
-        uint8_t retreived_value = ext_ram[i];
-        if (retreived_value != some_value)
-        {
-            printf_P(PSTR("Retrieval phase error: ext_ram[%4d] = %02X (should be %02X)\r\n"), i, retreived_value, some_value);
-            retrieval_errors++;
+    cpu_ticks_t ticks = cpu_time_ticks() - start;
+    sram_sink = sum;
+    return ticks;
+}
+
+static cpu_ticks_t sram_time_write(volatile uint8_t* p, uint16_t n, uint8_t repeat)
+{
+    cpu_ticks_t start = cpu_time_ticks();
+    while (repeat--) {
+        for (uint16_t i = 0; i < n; i++) {
+            p[i] = (uint8_t)i;
         }
     }
-    printf_P(PSTR("SRAM test completed with \r\n%4d errors in write phase and \r\n%4d errors in retrieval phase\r\n"), write_errors, retrieval_errors);
+    return cpu_time_ticks() - start;
+}
+
+static cpu_ticks_t sram_time_copy(uint8_t* dst, const uint8_t* src, uint16_t n, uint8_t repeat)
+{
+    cpu_ticks_t start = cpu_time_ticks();
+    while (repeat--) {
+        memcpy(dst, src, n);
+    }
+    return cpu_time_ticks() - start;
+}
+
+// kB/s for SRAM_BENCH_BYTES in the given time
+static uint16_t sram_rate(cpu_ticks_t ticks)
+{
+    if (ticks == 0) ticks = 1;
+    return (uint32_t)SRAM_BENCH_BYTES * CPU_TICKS_PER_SECOND / 1000 / ticks;
+}
+
+static void sram_bandwidth(void)
+{
+    uint8_t* ext = (uint8_t*)XMEM_SRAM_START;
+    uint8_t internal[SRAM_BENCH_INTERNAL * 2];
+    const uint8_t internal_repeat = SRAM_BENCH_BYTES / SRAM_BENCH_INTERNAL;
+
+    // Same loops over internal SRAM as the reference
+    cpu_ticks_t ext_read = sram_time_read(ext, SRAM_BENCH_BYTES, 1);
+    cpu_ticks_t int_read = sram_time_read(internal, SRAM_BENCH_INTERNAL, internal_repeat);
+    cpu_ticks_t ext_write = sram_time_write(ext, SRAM_BENCH_BYTES, 1);
+    cpu_ticks_t int_write = sram_time_write(internal, SRAM_BENCH_INTERNAL, internal_repeat);
+    cpu_ticks_t ext_copy = sram_time_copy(ext + SRAM_BENCH_BYTES, ext, SRAM_BENCH_BYTES, 1);
+    cpu_ticks_t int_copy = sram_time_copy(internal + SRAM_BENCH_INTERNAL, internal,
+                                          SRAM_BENCH_INTERNAL, internal_repeat);
+
+    printf_P(PSTR("          external  internal (kB/s)\r\n"));
+    printf_P(PSTR("read      %8u  %8u\r\n"), sram_rate(ext_read), sram_rate(int_read));
+    printf_P(PSTR("write     %8u  %8u\r\n"), sram_rate(ext_write), sram_rate(int_write));
+    printf_P(PSTR("copy      %8u  %8u\r\n"), sram_rate(ext_copy), sram_rate(int_copy));
+}
+
+void sram_test_setup(void)
+{
+    xmem_init();
+    uart_init(MYUBRR);
+    cpu_time_init();
+    printf_P(PSTR("Startup OK\r\n"));
+}
+
+void sram_test_loop(void)
+{
+    sram_result_t data = {0}, address = {0}, aliasing = {0}, march = {0};
+
+    // With SRL = 0 the whole window uses the upper sector wait states SRW11:SRW10
+    uint8_t srw = ((EMCUCR >> SRW11) & 1) << 1 | ((MCUCR >> SRW10) & 1);
+    uint8_t srl = (EMCUCR >> SRL0) & 0x07;
+    printf_P(PSTR("External SRAM 0x%04X-0x%04X, SRW1 %u, SRL %u\r\n"),
+             XMEM_SRAM_START, XMEM_SRAM_END - 1, srw, srl);
+
+    sram_data_bus(&data);
+    sram_address_bus(&address);
+    sram_aliasing(&aliasing);
+    sram_march_c(&march);
+    sram_print_result(PSTR("data bus     "), &data);
+    sram_print_result(PSTR("address bus  "), &address);
+    sram_print_result(PSTR("aliasing     "), &aliasing);
+    sram_print_result(PSTR("March C-     "), &march);
+
+    sram_bandwidth();
+    printf_P(PSTR("\r\n"));
+
+    _delay_ms(SRAM_REPORT_GAP_MS);
 }
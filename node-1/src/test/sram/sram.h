@@ -2,9 +2,9 @@
 
 #include <avr/pgmspace.h>
 #include "uart/uart.h"
-#include <stdlib.h>
-#include "uart/uart.h"
 #include "xmem/xmem.h"
+#include "adc/adc.h"
+#include "cpu_time/cpu_time.h"
 
 void sram_test_setup(void);
-void sram_test_loop(void);
+void sram_test_loop(void);      // Bus, aliasing and March C- tests plus bandwidth, summary only
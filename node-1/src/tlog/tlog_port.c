@@ -0,0 +1,43 @@
+// Node 1 side of the tokenized logger (common/tlog.h)
+#define TLOG_IMPLEMENTATION
+#include "tlog.h"
+#include "uart/uart.h"
+#include "cpu_time/cpu_time.h"
+#include "xmem/xmem.h"
+
+// Records in flight at once: the main loop plus one from an interrupt. Each record is
+// also its encoded frame, so a TLOG needs no frame-sized buffer in internal RAM.
+#define TLOG_POOL_RECORDS   2
+
+XMEM_POOL_DEFINE(tlog_pool, tlog_record_t, TLOG_POOL_RECORDS);
+
+tlog_record_t* tlog_record_alloc(void)
+{
+    return xmem_pool_alloc(&tlog_pool);
+}
+
+void tlog_record_free(tlog_record_t* record)
+{
+    xmem_pool_free(&tlog_pool, record);
+}
+
+uint32_t tlog_timestamp_ms(void)
+{
+    return (uint32_t)cpu_time_milliseconds();
+}
+
+// Whole frame into the UART TX ring or nothing, so a record is never cut by other output
+uint8_t tlog_output(const uint8_t *frame, uint8_t length)
+{
+    uint8_t sreg = SREG;
+    cli();
+    if (uart_tx_free() < length) {
+        SREG = sreg;
+        return 0;
+    }
+    for (uint8_t i = 0; i < length; i++) {
+        uart_transmit(frame[i]);
+    }
+    SREG = sreg;
+    return 1;
+}
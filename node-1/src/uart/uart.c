@@ -1,8 +1,17 @@
 #include "uart.h"
 
-// RX globals
-volatile unsigned char uart_rx_data = 0;
-volatile uint8_t uart_rx_flag = 0;
+// TX ring: filled by uart_transmit, drained by the UDRE interrupt
+static volatile uint8_t uart_tx_buffer[UART_TX_BUFFER_SIZE];
+static volatile uint8_t uart_tx_head = 0;   // Next free slot
+static volatile uint8_t uart_tx_tail = 0;   // Next character to send
+
+// RX ring: filled by the RXC interrupt, drained by uart_read/getchar
+static volatile uint8_t uart_rx_buffer[UART_RX_BUFFER_SIZE];
+static volatile uint8_t uart_rx_head = 0;
+static volatile uint8_t uart_rx_tail = 0;
+
+static uart_tx_policy_t uart_tx_policy = UART_TX_BLOCK;
+static volatile uart_stats_t uart_stats;
 
 // Forward declarations
 int uart_putchar(char c, FILE *stream);
@@ -14,44 +23,124 @@ void uart_init(unsigned int ubrr)
     UBRR0H = (unsigned char)(ubrr >> 8);
     UBRR0L = (unsigned char)ubrr;
 
-    // Enable RX, TX and RX complete interrupt
-    UCSR0B = (1 << RXEN0) | (1 << TXEN0);
+    // Enable RX, TX and RX complete interrupt (UDRE is enabled while there is data to send)
+    UCSR0B = (1 << RXEN0) | (1 << TXEN0) | (1 << RXCIE0);
 
     // Frame format: 8 data, 1 stop, no parity
     UCSR0C = (1 << URSEL0) | (1 << UCSZ01) | (1 << UCSZ00);
 
-    // Connect stdio streams (printf + getchar/scanf)
-    fdevopen(uart_putchar, uart_getchar);
+    // Connect stdio streams (printf + getchar/scanf) once, uart_init is called by every test setup
+    static uint8_t streams_open = 0;
+    if (!streams_open) {
+        fdevopen(uart_putchar, uart_getchar);
+        streams_open = 1;
+    }
 
     sei();
 }
 
 void uart_transmit(unsigned char data)
 {
-    while (!(UCSR0A & (1 << UDRE0)))
+    for (;;) {
+        // Interrupts off around the head update: interrupt context may write here too
+        uint8_t sreg = SREG;
+        cli();
+        uint8_t next = (uart_tx_head + 1) & (UART_TX_BUFFER_SIZE - 1);
+        if (next != uart_tx_tail) {
+            uart_tx_buffer[uart_tx_head] = data;
+            uart_tx_head = next;
+            UCSR0B |= (1 << UDRIE0);
+            SREG = sreg;
+            return;
+        }
+        // Full: blocking with interrupts off would never end, so drop in that case too
+        if (uart_tx_policy == UART_TX_DROP || !(sreg & (1 << SREG_I))) {
+            uart_stats.tx_drops++;
+            SREG = sreg;
+            return;
+        }
+        SREG = sreg;    // Let the UDRE interrupt make room
+    }
+}
+
+void uart_send_string(const char *s)
+{
+    while (*s) {
+        uart_transmit(*s++);
+    }
+}
+
+uint8_t uart_tx_free(void)
+{
+    return (uart_tx_tail - uart_tx_head - 1) & (UART_TX_BUFFER_SIZE - 1);
+}
+
+int16_t uart_read(void)
+{
+    if (uart_rx_head == uart_rx_tail) {
+        return -1;
+    }
+    uint8_t c = uart_rx_buffer[uart_rx_tail];
+    uart_rx_tail = (uart_rx_tail + 1) & (UART_RX_BUFFER_SIZE - 1);
+    return c;
+}
+
+void uart_set_tx_policy(uart_tx_policy_t policy)
+{
+    uart_tx_policy = policy;
+}
+
+void uart_get_stats(uart_stats_t *stats)
+{
+    uint8_t sreg = SREG;
+    cli();
+    *stats = uart_stats;
+    SREG = sreg;
+}
+
+void uart_flush(void)
+{
+    while (uart_tx_head != uart_tx_tail)
         ;
-    UDR0 = data;
 }
 
 int uart_putchar(char c, FILE *stream)
 {
-
     uart_transmit(c);
     return 0;
 }
 
 int uart_getchar(FILE *stream)
 {
-    while (!(UCSR0A & (1 << RXC0)))
+    int16_t c;
+    while ((c = uart_read()) < 0)
         ; // wait until data received
-    return UDR0;
+    return c;
 }
 
-/*
-// RX interrupt (optional, not needed for getchar/scanf)
-ISR(USART_RXC_vect) {
-    uart_rx_data = UDR0;
-    uart_rx_flag = 1;
+// Data register empty: send the next queued character, stop when the ring is empty
+ISR(USART0_UDRE_vect)
+{
+    if (uart_tx_head == uart_tx_tail) {
+        UCSR0B &= ~(1 << UDRIE0);
+        return;
+    }
+    UDR0 = uart_tx_buffer[uart_tx_tail];
+    uart_tx_tail = (uart_tx_tail + 1) & (UART_TX_BUFFER_SIZE - 1);
 }
 
-*/
+// RX complete: queue the character, count it if there is no room or the hardware overran
+ISR(USART0_RXC_vect)
+{
+    if (UCSR0A & (1 << DOR0)) {
+        uart_stats.rx_drops++;
+    }
+    uint8_t c = UDR0;
+    uint8_t next = (uart_rx_head + 1) & (UART_RX_BUFFER_SIZE - 1);
+    if (next == uart_rx_tail) {
+        uart_stats.rx_drops++;
+        return;
+    }
+    uart_rx_buffer[uart_rx_head] = c;
+    uart_rx_head = next;
+}
@@ -7,9 +7,36 @@
 #include <avr/interrupt.h>
 
 // === UART config ===
-#define BAUD 9600       // 9600 baud rate 
-#define MYUBRR (F_CPU / 16 / BAUD - 1) //Calculate MYUBRR value for given F_CPU and BAUD rate should be 31 for 4.9152MHz and 9600 baud rate
+// Exact rates with the 4.9152 MHz crystal: 9600, 19200, 38400, 76800, 153600.
+// 115200 is not reachable (nearest UBRR is 6.7% off) and fails the check below.
+#ifndef BAUD
+#define BAUD 38400
+#endif
+#define MYUBRR ((F_CPU + 8UL * BAUD) / (16UL * BAUD) - 1)   // Rounded, 7 for 38400 baud
 
+// Baud rate the divider really gives, must be within 2% of BAUD
+#define UART_BAUD_ACTUAL (F_CPU / 16 / (MYUBRR + 1))
+_Static_assert(UART_BAUD_ACTUAL * 100 >= BAUD * 98UL && UART_BAUD_ACTUAL * 100 <= BAUD * 102UL,
+               "BAUD is not reachable within 2% with this F_CPU");
+
+// Ring buffer sizes (powers of two, internal SRAM)
+#define UART_TX_BUFFER_SIZE 64
+#define UART_RX_BUFFER_SIZE 16
+_Static_assert((UART_TX_BUFFER_SIZE & (UART_TX_BUFFER_SIZE - 1)) == 0 && UART_TX_BUFFER_SIZE <= 256,
+               "UART_TX_BUFFER_SIZE must be a power of two up to 256");
+_Static_assert((UART_RX_BUFFER_SIZE & (UART_RX_BUFFER_SIZE - 1)) == 0 && UART_RX_BUFFER_SIZE <= 256,
+               "UART_RX_BUFFER_SIZE must be a power of two up to 256");
+
+// What uart_transmit does when the TX ring is full
+typedef enum {
+    UART_TX_BLOCK,      // Wait for room (default, nothing is lost)
+    UART_TX_DROP        // Drop the character and count it
+} uart_tx_policy_t;
+
+typedef struct {
+    uint16_t tx_drops;      // Characters dropped because the TX ring was full
+    uint16_t rx_drops;      // Characters lost: RX ring full or hardware overrun
+} uart_stats_t;
 
 
 // === API ===
@@ -17,6 +44,14 @@ void uart_init(unsigned int ubrr);
 void uart_transmit(unsigned char data);
 void uart_send_string(const char *s);
 
-// RX globals (set by ISR, read in main)
-extern volatile unsigned char uart_rx_data;
-extern volatile uint8_t uart_rx_flag;
+// Free space in the TX ring
+uint8_t uart_tx_free(void);
+
+// Next received character, -1 if none (never blocks)
+int16_t uart_read(void);
+
+void uart_set_tx_policy(uart_tx_policy_t policy);
+void uart_get_stats(uart_stats_t *stats);
+
+// Wait until the TX ring is empty (the last character may still be shifting out)
+void uart_flush(void);
@@ -1,7 +1,162 @@
 #include "xmem.h"
+#include <avr/interrupt.h>
+#include <stdio.h>
+
+// Free internal SRAM is filled with this at reset; the stack overwrites it
+#define XMEM_STACK_PAINT    0xC5
+
+// Linker symbols (avr-libc)
+extern uint8_t __data_start;
+extern uint8_t __bss_end;
+extern uint8_t __heap_start;
+extern char* __brkval;
+
+// Bounds of the xmem section, defined by the linker when the section exists
+extern uint8_t __start_xmem[] __attribute__((weak));
+extern uint8_t __stop_xmem[] __attribute__((weak));
+
+static uint8_t* xmem_arena_next;
+static uint16_t xmem_arena_failures = 0;
+static xmem_pool_t* xmem_pools = NULL;
+
+// Runs after .init2 (stack pointer and zero register set up) and before .data
+// and .bss are initialised. Naked and never called, so it must not use the stack.
+void xmem_startup(void) __attribute__((naked, used, section(".init3")));
+void xmem_startup(void)
+{
+    MCUCR |= (1 << SRE);
+    SFIOR |= (1 << XMM2);
+
+    for (uint8_t* p = &__heap_start; p <= (uint8_t*)RAMEND; p++) {
+        *p = XMEM_STACK_PAINT;
+    }
+}
 
 void xmem_init(void)
 {
     MCUCR |= (1 << SRE);  // enable XMEM
     SFIOR |= (1 << XMM2); // mask bits / reduce bus width
 }
+
+// First byte after the section (the arena starts here)
+static uint8_t* xmem_section_end(void)
+{
+    return __stop_xmem ? __stop_xmem : (uint8_t*)XMEM_SRAM_START;
+}
+
+void* xmem_arena_alloc(uint16_t size)
+{
+    uint8_t sreg = SREG;
+    cli();
+    if (xmem_arena_next == NULL) {
+        xmem_arena_next = xmem_section_end();
+    }
+
+    void* block = NULL;
+    if (size <= (uint16_t)((uint8_t*)XMEM_SRAM_END - xmem_arena_next)) {
+        block = xmem_arena_next;
+        xmem_arena_next += size;
+    } else {
+        xmem_arena_failures++;
+    }
+    SREG = sreg;
+    return block;
+}
+
+void* xmem_arena_alloc_or_halt(uint16_t size, PGM_P owner)
+{
+    void* block = xmem_arena_alloc(size);
+    if (block == NULL) {
+        // Layout error (see xmem_report); stop rather than write through NULL
+        printf_P(PSTR("%S: no external SRAM for %u bytes\r\n"), owner, size);
+        while (1) { }
+    }
+    return block;
+}
+
+void* xmem_pool_alloc(xmem_pool_t* pool)
+{
+    uint8_t sreg = SREG;
+    cli();
+    if (!pool->listed) {
+        pool->next = xmem_pools;
+        xmem_pools = pool;
+        pool->listed = true;
+    }
+
+    void* block = NULL;
+    uint16_t mask = 1;
+    for (uint8_t i = 0; i < pool->count; i++, mask <<= 1) {
+        if (!(pool->used & mask)) {
+            pool->used |= mask;
+            block = pool->storage + (uint16_t)i * pool->block_size;
+            if (++pool->in_use > pool->peak) pool->peak = pool->in_use;
+            break;
+        }
+    }
+    if (block == NULL) {
+        pool->failures++;
+    }
+    SREG = sreg;
+    return block;
+}
+
+void xmem_pool_free(xmem_pool_t* pool, void* block)
+{
+    if (block == NULL) return;
+
+    uint8_t i = (uint16_t)((uint8_t*)block - pool->storage) / pool->block_size;
+    uint8_t sreg = SREG;
+    cli();
+    uint16_t mask = (uint16_t)1 << i;
+    if (pool->used & mask) {
+        pool->used &= ~mask;
+        pool->in_use--;
+    }
+    SREG = sreg;
+}
+
+void xmem_report(void)
+{
+    // Internal: the stack grew down to the lowest byte that lost its paint
+    uint8_t* heap_end = __brkval ? (uint8_t*)__brkval : &__heap_start;
+    uint8_t* p = heap_end;
+    while (p <= (uint8_t*)RAMEND && *p == XMEM_STACK_PAINT) {
+        p++;
+    }
+    uint16_t statics = &__bss_end - &__data_start;
+    uint16_t heap = heap_end - &__heap_start;
+    uint16_t stack_peak = (uint8_t*)RAMEND + 1 - p;
+    uint16_t never_used = p - heap_end;
+
+    printf_P(PSTR("Internal SRAM %u B: data+bss %u, heap %u, stack peak %u, never used %u\r\n"),
+             RAMEND + 1 - RAMSTART, statics, heap, stack_peak, never_used);
+
+    // External
+    uint8_t sreg = SREG;
+    cli();
+    uint8_t* arena_next = xmem_arena_next ? xmem_arena_next : xmem_section_end();
+    uint16_t arena_failures = xmem_arena_failures;
+    SREG = sreg;
+    uint8_t* section_start = __start_xmem ? __start_xmem : (uint8_t*)XMEM_SRAM_START;
+
+    printf_P(PSTR("External SRAM %u B: section %u, arena %u, free %u, arena failures %u\r\n"),
+             XMEM_SRAM_SIZE, (uint16_t)(xmem_section_end() - section_start),
+             (uint16_t)(arena_next - xmem_section_end()),
+             (uint16_t)((uint8_t*)XMEM_SRAM_END - arena_next), arena_failures);
+
+    printf_P(PSTR("pool           block count in use  peak failures\r\n"));
+    for (xmem_pool_t* pool = xmem_pools; pool; pool = pool->next) {
+        char name[15];
+        strncpy_P(name, pool->name, sizeof(name) - 1);
+        name[sizeof(name) - 1] = '\0';
+        sreg = SREG;
+        cli();
+        uint8_t in_use = pool->in_use;
+        uint8_t peak = pool->peak;
+        uint16_t failures = pool->failures;
+        SREG = sreg;
+        printf_P(PSTR("%-14s %5u %5u %6u %5u %8u\r\n"), name, pool->block_size, pool->count,
+                 in_use, peak, failures);
+    }
+}
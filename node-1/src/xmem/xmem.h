@@ -1,4 +1,85 @@
+#pragma once
 
 #include <avr/io.h>
+#include <avr/pgmspace.h>
+#include <stdint.h>
+#include <stdbool.h>
 
+/*
+ * External SRAM (see docs/wiring_tables.md for the decoder).
+ *
+ * XMEM is switched on from .init3, before .data/.bss are set up, so buffers
+ * out here are usable from the first line of main(). Their contents are not
+ * cleared at reset.
+ *
+ * The SRAM window is laid out bottom up:
+ *   XMEM_SECTION buffers    static arrays the linker places at XMEM_SRAM_START
+ *   arena                   xmem_arena_alloc(), never freed (framebuffer, tables)
+ *
+ * Fixed-size pools (XMEM_POOL_DEFINE) take their blocks from an XMEM_SECTION
+ * array and are safe to use from interrupts.
+ */
+
+#define XMEM_ADC_ADDR       0x1000      // MAX156, A11:A10 = 00
+#define XMEM_SRAM_START     0x1400      // Must match --section-start=xmem in the Makefile
+#define XMEM_SRAM_END       0x2000      // Exclusive; A15:A12 are released to JTAG (XMM2)
+#define XMEM_SRAM_SIZE      (XMEM_SRAM_END - XMEM_SRAM_START)
+
+#define XMEM_QUERY          'm'         // UART command that prints xmem_report()
+
+// Place a static buffer in external SRAM: static uint8_t buf[512] XMEM_SECTION;
+#define XMEM_SECTION        __attribute__((section("xmem")))
+
+// Up to 16 blocks of up to 255 bytes, allocated from a bitmap
+typedef struct xmem_pool_t {
+    uint8_t* storage;           // count * block_size bytes in external SRAM
+    PGM_P name;
+    uint8_t block_size;
+    uint8_t count;
+    uint16_t used;              // Bit n: block n is allocated
+    uint8_t in_use;
+    uint8_t peak;
+    uint16_t failures;          // Allocations refused because every block was taken
+    struct xmem_pool_t* next;   // Report list, linked on first allocation
+    bool listed;
+} xmem_pool_t;
+
+// Defines `pool` with n blocks of `type` (static, file scope)
+#define XMEM_POOL_DEFINE(pool, type, n) \
+    _Static_assert((n) <= 16 && sizeof(type) <= 255, "xmem pool too large"); \
+    static type pool##_storage[n] XMEM_SECTION; \
+    static const char pool##_name[] PROGMEM = #pool; \
+    static xmem_pool_t pool = { (uint8_t*)pool##_storage, pool##_name, sizeof(type), (n) }
+
+/**
+ * Enable the external memory interface (already done at startup, kept for
+ * code that runs before or without the C runtime).
+ */
 void xmem_init(void);
+
+/**
+ * Take size bytes from the arena, or NULL (and count a failure) if it is full.
+ */
+void* xmem_arena_alloc(uint16_t size);
+
+/**
+ * xmem_arena_alloc() for buffers a driver cannot run without: if the arena is
+ * full, print owner (a PSTR) and halt rather than hand out NULL.
+ */
+void* xmem_arena_alloc_or_halt(uint16_t size, PGM_P owner);
+
+/**
+ * Take one block from the pool, or NULL if all are in use. Interrupt safe.
+ */
+void* xmem_pool_alloc(xmem_pool_t* pool);
+
+/**
+ * Return a block to its pool. Interrupt safe.
+ */
+void xmem_pool_free(xmem_pool_t* pool, void* block);
+
+/**
+ * Internal SRAM (static data, heap, stack high-water mark from the paint
+ * left at startup) and external SRAM (section, arena, pools) over the UART.
+ */
+void xmem_report(void);
@@ -1,6 +1,7 @@
 
 #include "sam.h"
 #include "can.h"
+#include "can_stats.h"
 #include <stdio.h> 
 
 void can_printmsg(CanMsg m){
@@ -67,6 +68,8 @@ void can_init(CanInit init, uint8_t rxInterrupt){
 
     // Enable CAN
     CAN0->CAN_MR |= CAN_MR_CANEN;
+    
+    can_stats_reset();
 }
 
 
@@ -78,6 +81,7 @@ void can_tx(CanMsg m){
         if (timeout == 0) {
             printf("ERROR: TX mailbox timeout! MSR=0x%08lX\n", CAN0->CAN_MB[txMailbox].CAN_MSR);
             printf("CAN Status: SR=0x%08lX, ECR=0x%08lX\n", CAN0->CAN_SR, CAN0->CAN_ECR);
+            can_stats_count_drop();
             return; // Don't send if mailbox stuck
         }
     }
@@ -94,18 +98,25 @@ void can_tx(CanMsg m){
         
     // Set message length and mailbox ready to send
     CAN0->CAN_MB[txMailbox].CAN_MCR = (m.length << CAN_MCR_MDLC_Pos) | CAN_MCR_MTCR;
+    can_stats_count_tx(&m);
 }
 
 uint8_t can_rx(CanMsg* m){
-    if(!(CAN0->CAN_MB[rxMailbox].CAN_MSR & CAN_MSR_MRDY)){
+    uint32_t msr = CAN0->CAN_MB[rxMailbox].CAN_MSR;
+    if(!(msr & CAN_MSR_MRDY)){
         return 0;
     }
+    
+    // MMI: at least one frame arrived while this one was waiting and was lost
+    if(msr & CAN_MSR_MMI){
+        can_stats_count_overrun();
+    }
 
     // Get message ID
     m->id = (uint8_t)((CAN0->CAN_MB[rxMailbox].CAN_MID & CAN_MID_MIDvA_Msk) >> CAN_MID_MIDvA_Pos);
         
     // Get data length
-    m->length = (uint8_t)((CAN0->CAN_MB[rxMailbox].CAN_MSR & CAN_MSR_MDLC_Msk) >> CAN_MSR_MDLC_Pos);
+    m->length = (uint8_t)((msr & CAN_MSR_MDLC_Msk) >> CAN_MSR_MDLC_Pos);
     
     // Get data from CAN mailbox
     m->dword[0] = CAN0->CAN_MB[rxMailbox].CAN_MDL;
@@ -114,6 +125,7 @@ uint8_t can_rx(CanMsg* m){
     // Reset for new receive
     CAN0->CAN_MB[rxMailbox].CAN_MMR = CAN_MMR_MOT_MB_RX;
     CAN0->CAN_MB[rxMailbox].CAN_MCR |= CAN_MCR_MTCR;
+    can_stats_count_rx(m);
     return 1;
 }
     
@@ -2,16 +2,18 @@
 #pragma once
 
 #include <stdint.h>
+#include "can_bitrate.h"
+#include "protocol.h"    // union_cast, Byte8, message payloads
 
-// Struct with bit timing information
-// See `can_init` for usage example
+// Struct with bit timing information, laid out like CAN_BR
+// Fields hold register values (segment length - 1), see `can_init` for usage example
 typedef struct CanInit CanInit;  
 __attribute__((packed)) struct CanInit {
     union {
         struct {
             uint32_t phase2:4;  // Phase 2 segment
-            uint32_t propag:4;  // Propagation time segment
             uint32_t phase1:4;  // Phase 1 segment
+            uint32_t propag:4;  // Propagation time segment
             uint32_t sjw:4;     // Synchronization jump width
             uint32_t brp:8;     // Baud rate prescaler
             uint32_t smp:8;     // Sampling mode
@@ -24,31 +26,16 @@ __attribute__((packed)) struct CanInit {
 // Initialize CAN bus, with bit timings and optional interrupt
 // If `rxInterrupt` is not 0, an interrupt will be triggered when a message is received.
 // (See can.c for an example interrupt handler)
-// Example:
-//    can_init((CanInit){.brp = F_CPU/2000000-1, .phase1 = 5, .phase2 = 1, .propag = 6}, 0);
+// Example (bit timing shared with Node 1, see common/can_bitrate.h):
+//    can_init((CanInit){.reg = CAN_SAM_BR}, 0);
 void can_init(CanInit init, uint8_t rxInterrupt);
 
 
-// Strict-aliasing-safe reinterpret-cast
-#define union_cast(type, x) \
-    (((union { \
-        typeof(x) a; \
-        type b; \
-    })x).b)
-
-
-// Dummy type for use with `union_cast`, see below
-typedef struct Byte8 Byte8;
-struct Byte8 {
-    uint8_t bytes[8];
-};
-
-
 // CAN message data type
 // Data fields have 3 access methods (via union):
 //  8 bytes
 //  2 double words (32-bit ints)
-//  1 Byte8 dummy struct
+//  1 Byte8 dummy struct (common/protocol.h)
 // The dummy struct allows for convenient construction of a CAN message from another type
 //
 // Example:
@@ -0,0 +1,121 @@
+/*
+ * can_stats.c - CAN bus health and throughput counters for Node 2
+ */
+
+#include <stdio.h>
+#include <stdbool.h>
+#include "sam.h"
+#include "can_stats.h"
+#include "uart.h"
+#include "time.h"
+
+static CanStats stats;
+static uint32_t window_bits;        // Wire bits since the window started
+static uint64_t window_start;
+static bool bus_off_now;            // BOFF seen at the last sample
+static proto_diag_t peer;           // Last diagnostics frame from Node 1
+static bool peer_valid;
+
+static uint8_t sat8(uint32_t value){
+    return value > 0xFF ? 0xFF : (uint8_t)value;
+}
+
+void can_stats_reset(void){
+    stats = (CanStats){0};
+    window_bits = 0;
+    window_start = time_now();
+    bus_off_now = false;
+}
+
+void can_stats_count_tx(const CanMsg* m){
+    stats.tx[m->id]++;
+    window_bits += CAN_FRAME_BITS(m->length);
+}
+
+void can_stats_count_rx(const CanMsg* m){
+    stats.rx[m->id]++;
+    window_bits += CAN_FRAME_BITS(m->length > 8 ? 8 : m->length);
+    if(PROTO_IS(*m, PROTO_ID_DIAG_NODE1, proto_diag_t)){
+        peer = PROTO_DECODE(proto_diag_t, *m);
+        peer_valid = true;
+    }
+}
+
+void can_stats_count_drop(void){
+    stats.tx_drops++;
+}
+
+void can_stats_count_overrun(void){
+    stats.rx_overruns++;
+}
+
+void can_stats_service(void){
+    uint8_t c;
+    if(uart_rx(&c) && c == CAN_STATS_QUERY){
+        can_stats_print();
+    }
+    
+    uint64_t now = time_now();
+    if(now - window_start < msecs(CAN_STATS_PERIOD_MS)){
+        return;
+    }
+    uint32_t elapsed_ms = (uint32_t)totalMsecs(now - window_start);
+    window_start = now;
+    
+    // Error counters and bus-off
+    uint32_t ecr = CAN0->CAN_ECR;
+    uint8_t tec = (ecr & CAN_ECR_TEC_Msk) >> CAN_ECR_TEC_Pos;
+    uint8_t rec = (ecr & CAN_ECR_REC_Msk) >> CAN_ECR_REC_Pos;
+    stats.tec = tec;
+    stats.rec = rec;
+    if(tec > stats.tec_peak) stats.tec_peak = tec;
+    if(rec > stats.rec_peak) stats.rec_peak = rec;
+    bool bus_off = (CAN0->CAN_SR & CAN_SR_BOFF) != 0;
+    if(bus_off && !bus_off_now){
+        stats.bus_off++;
+    }
+    bus_off_now = bus_off;
+    
+    // bits / (bit/s * s), in permille
+    uint32_t load = (uint32_t)((uint64_t)window_bits * 1000000 / ((uint64_t)CAN_BITRATE * elapsed_ms));
+    window_bits = 0;
+    if(load > 1000) load = 1000;
+    stats.load_permille = load;
+    if(load > stats.load_peak_permille) stats.load_peak_permille = load;
+    
+    if(!bus_off){
+        can_tx((CanMsg){
+            PROTO_MSG(PROTO_ID_DIAG_NODE2, proto_diag_t,
+                .load_permille = load,
+                .tec_peak = stats.tec_peak,
+                .rec_peak = stats.rec_peak,
+                .bus_off = sat8(stats.bus_off),
+                .drops = sat8(stats.tx_drops),
+                .overruns = sat8(stats.rx_overruns))
+        });
+    }
+}
+
+const CanStats* can_stats_get(void){
+    return &stats;
+}
+
+void can_stats_print(void){
+    printf("\n=== CAN stats (%lu kbps) ===\n", (unsigned long)(CAN_BITRATE / 1000));
+    for(int id = 0; id < 256; id++){
+        if(stats.tx[id] || stats.rx[id]){
+            printf("ID 0x%03X  TX %8lu  RX %8lu\n", id, stats.tx[id], stats.rx[id]);
+        }
+    }
+    printf("Load %u.%u%% (peak %u.%u%%)\n",
+           stats.load_permille / 10, stats.load_permille % 10,
+           stats.load_peak_permille / 10, stats.load_peak_permille % 10);
+    printf("TEC %u (peak %u)  REC %u (peak %u)  bus-off %u\n",
+           stats.tec, stats.tec_peak, stats.rec, stats.rec_peak, stats.bus_off);
+    printf("TX drops %lu  RX overruns %lu\n", stats.tx_drops, stats.rx_overruns);
+    if(peer_valid){
+        printf("Node 1: load %u.%u%%  TEC peak %u  REC peak %u  bus-off %u  drops %u  overruns %u\n",
+               peer.load_permille / 10, peer.load_permille % 10,
+               peer.tec_peak, peer.rec_peak, peer.bus_off, peer.drops, peer.overruns);
+    }
+}
@@ -0,0 +1,66 @@
+/*
+ * can_stats.h - CAN bus health and throughput counters for Node 2
+ *
+ * can.c reports every frame it sends or receives. can_stats_service(),
+ * called from the main loops, samples CAN_ECR/CAN_SR once per period, turns
+ * the frame sizes into a bus load estimate, publishes a PROTO_ID_DIAG_NODE2
+ * frame and prints the counters when CAN_STATS_QUERY arrives on the UART.
+ */
+
+#ifndef CAN_STATS_H
+#define CAN_STATS_H
+
+#include <stdint.h>
+#include "can.h"
+
+// Load window and diagnostics frame period (ms)
+#define CAN_STATS_PERIOD_MS 1000
+
+// UART command that prints the statistics
+#define CAN_STATS_QUERY     's'
+
+typedef struct {
+    uint32_t tx[256];           // Frames written to the TX mailbox, per ID
+    uint32_t rx[256];           // Frames received, per ID
+    uint32_t tx_drops;          // can_tx gave up on a stuck mailbox
+    uint32_t rx_overruns;       // Frames ignored because the RX mailbox was still full (MMI)
+    uint8_t tec, rec;           // Error counters at the last sample
+    uint8_t tec_peak, rec_peak;
+    uint16_t bus_off;           // Bus-off events
+    uint16_t load_permille;     // Estimated bus load over the last period
+    uint16_t load_peak_permille;
+} CanStats;
+
+/**
+ * @brief Clear all counters and start a new load window
+ */
+void can_stats_reset(void);
+
+/**
+ * @brief Count frames (called by can.c); keeps Node 1's diagnostics frame
+ */
+void can_stats_count_tx(const CanMsg* m);
+void can_stats_count_rx(const CanMsg* m);
+void can_stats_count_drop(void);
+void can_stats_count_overrun(void);
+
+/**
+ * @brief Periodic work, call from the main loop
+ *
+ * Every CAN_STATS_PERIOD_MS: sample error counters and bus-off state,
+ * update the load estimate and send the diagnostics frame.
+ * Prints the counters when CAN_STATS_QUERY was received on the UART.
+ */
+void can_stats_service(void);
+
+/**
+ * @brief Read-only access to the counters
+ */
+const CanStats* can_stats_get(void);
+
+/**
+ * @brief Print the counters (and Node 1's last diagnostics frame)
+ */
+void can_stats_print(void);
+
+#endif // CAN_STATS_H
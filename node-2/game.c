@@ -6,6 +6,7 @@
 #include "game.h"
 #include "sam.h"
 #include "can.h"
+#include "can_stats.h"
 #include "motor.h"
 #include "encoder.h"
 #include "servo.h"
@@ -24,8 +25,7 @@ void game_init(void) {
     ir_sensor_init();
     
     // CAN init
-    can_init((CanInit){.brp=20, .propag=2, .phase1=7, .phase2=6, .sjw=1, .smp=0}, 0);
-    CAN0->CAN_BR = 0x00290165;
+    can_init((CanInit){.reg = CAN_SAM_BR}, 0);
 }
 
 void game_loop(void) {
@@ -33,11 +33,14 @@ void game_loop(void) {
     static bool last_button_state = false;
     
     while (1) {
+        // Bus health: diagnostics frame once a second, 's' on UART prints the counters
+        can_stats_service();
+        
         switch (current_state) {
             case GAME_STATE_MENU:
                 // Wait for start signal (joystick button with edge detection)
-                if (can_rx(&msg) && msg.id == 0x00 && msg.length >= 3) {
-                    bool button_pressed = (msg.byte[2] != 0);
+                if (can_rx(&msg) && PROTO_IS_JOYSTICK(msg)) {
+                    bool button_pressed = (PROTO_DECODE(proto_joystick_t, msg).button != 0);
                     
                     // Rising edge detection - button just pressed
                     if (button_pressed && !last_button_state) {
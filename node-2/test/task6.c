@@ -105,38 +105,21 @@ void task2_uart_test(void) {
  * Task 3 Test: CAN Communication Test
  * Tests CAN initialization and receives messages from Node 1
  * 
- * Uses the exact working configuration from elinemha/TTK4155 repo:
- * - 125 kbps bit rate (perfect match with Node 1)
- * - CAN_BR = 0x00290165 (proven working register value)
+ * Uses the bit-timing profile shared with Node 1 (common/can_bitrate.h):
+ * - 125 kbps bit rate by default
+ * - CAN_BR derived from the same table as Node 1's CNF1-3
  * - Receive-only mode for clean testing
  */
 void task3_can_test(void) {
     printf("=== Task 3: CAN Communication Test ===\n");
-    printf("Initializing CAN at 125 kbps (EXACT MATCH)...\n");
+    printf("Initializing CAN at %lu kbps...\n", (unsigned long)(CAN_BITRATE / 1000));
     
-    // WORKING CONFIGURATION from elinemha/TTK4155 repo
-    // Use exact CAN_BR register value: 0x00290165
-    // This matches their proven working 125 kbps configuration
-    // that successfully communicates with MCP2515 Node 1
-    
-    uint32_t working_can_br = 0x00290165;  // From elinemha repo
-    
-    // Initialize CAN with working configuration  
-    can_init((CanInit){
-        .brp = 20,      // Try exact 125 kbps: 42MHz / 21 / 16TQ = 125.0 kbps
-        .propag = 2,    // Match Node 1's propagation segment
-        .phase1 = 7,    // Match Node 1's phase1 segment  
-        .phase2 = 6,    // Match Node 1's phase2 segment
-        .sjw = 1,       // SJW = 1 TQ
-        .smp = 0        // Single sampling
-    }, 0);  // No RX interrupt
-    
-    // Override with exact working register value
-    CAN0->CAN_BR = working_can_br;
+    // Bit timing from the profile shared with Node 1 (common/can_bitrate.h)
+    can_init((CanInit){.reg = CAN_SAM_BR}, 0);  // No RX interrupt
     
     printf("CAN initialized successfully!\n");
-    printf("- Bit rate: 125.0 kbps (EXACT match with Node 1)\n");
-    printf("- Using proven working CAN_BR = 0x%08X from elinemha repo\n", working_can_br);
+    printf("- Bit rate: %lu kbps (same profile as Node 1)\n", (unsigned long)(CAN_BITRATE / 1000));
+    printf("- CAN_BR = 0x%08lX\n", (unsigned long)CAN_SAM_BR);
     printf("- Mode: Receive-only (listening for Node 1)\n");
     
     // Check CAN status
@@ -223,23 +206,24 @@ typedef struct {
  * Returns true if message was successfully decoded as joystick data
  */
 bool decode_joystick_message(const CanMsg* msg, joystick_data_t* joy_data) {
-    // Check if this is a joystick message (ID 0x100 from Node 1)
-    if (msg->id != 0x100 && msg->id != 0x000) {  // Handle both possible ID formats
+    if (msg->id != PROTO_ID_JOYSTICK) {
         return false;  // Not a joystick message
     }
     
-    // Check if message has correct length
-    if (msg->length != 5) {
-        printf("Warning: Joystick message has wrong length (%d, expected 5)\n", msg->length);
+    // Check length and protocol version
+    if (!PROTO_IS(*msg, PROTO_ID_JOYSTICK, proto_joystick_t)) {
+        printf("Warning: Joystick message has wrong length/version (%d, expected %d)\n",
+               msg->length, (int)sizeof(proto_joystick_t));
         return false;
     }
     
     // Extract joystick data from CAN message
-    joy_data->joy_x      = msg->byte[0];  // Joystick X (0-100%)
-    joy_data->joy_y      = msg->byte[1];  // Joystick Y (0-100%)
-    joy_data->joy_button = msg->byte[2];  // Button state (0/1)
-    joy_data->slider_x   = msg->byte[3];  // Slider X (0-255)
-    joy_data->slider_y   = msg->byte[4];  // Slider Y (0-255)
+    proto_joystick_t joy = PROTO_DECODE(proto_joystick_t, *msg);
+    joy_data->joy_x      = joy.x;         // Joystick X (0-100%)
+    joy_data->joy_y      = joy.y;         // Joystick Y (0-100%)
+    joy_data->joy_button = joy.button;    // Button state (0/1)
+    joy_data->slider_x   = joy.slider_x;  // Slider X (0-255)
+    joy_data->slider_y   = joy.slider_y;  // Slider Y (0-255)
     
     return true;  // Successfully decoded
 }
@@ -273,26 +257,14 @@ void display_joystick_data(const joystick_data_t* joy_data) {
  */
 void task3_can_test_with_joystick_decoder(void) {
     printf("=== Task 3: CAN Communication Test (With Joystick Decoder) ===\n");
-    printf("Initializing CAN at 125 kbps (EXACT MATCH)...\n");
+    printf("Initializing CAN at %lu kbps...\n", (unsigned long)(CAN_BITRATE / 1000));
     
-    uint32_t working_can_br = 0x00290165;  // From elinemha repo
-    
-    // Initialize CAN with working configuration  
-    can_init((CanInit){
-        .brp = 20,      // Try exact 125 kbps: 42MHz / 21 / 16TQ = 125.0 kbps
-        .propag = 2,    // Match Node 1's propagation segment
-        .phase1 = 7,    // Match Node 1's phase1 segment  
-        .phase2 = 6,    // Match Node 1's phase2 segment
-        .sjw = 1,       // SJW = 1 TQ
-        .smp = 0        // Single sampling
-    }, 0);  // No RX interrupt
-    
-    // Override with exact working register value
-    CAN0->CAN_BR = working_can_br;
+    // Bit timing from the profile shared with Node 1 (common/can_bitrate.h)
+    can_init((CanInit){.reg = CAN_SAM_BR}, 0);  // No RX interrupt
     
     printf("CAN initialized successfully!\n");
-    printf("- Bit rate: 125.0 kbps (EXACT match with Node 1)\n");
-    printf("- Using proven working CAN_BR = 0x%08X from elinemha repo\n", working_can_br);
+    printf("- Bit rate: %lu kbps (same profile as Node 1)\n", (unsigned long)(CAN_BITRATE / 1000));
+    printf("- CAN_BR = 0x%08lX\n", (unsigned long)CAN_SAM_BR);
     printf("- Mode: Receive-only with joystick decoder\n\n");
     
     printf("Waiting for joystick data from Node 1...\n");
@@ -463,12 +435,7 @@ void task7_servo_joystick_test(void) {
     printf("Move joystick on Node 1 to control servo position\n\n");
     
     // Initialize CAN (using working configuration from Task 3)
-    uint32_t working_can_br = 0x00290165;
-    
-    can_init((CanInit){
-        .brp = 20, .propag = 2, .phase1 = 7, .phase2 = 6, .sjw = 1, .smp = 0
-    }, 0);
-    CAN0->CAN_BR = working_can_br;
+    can_init((CanInit){.reg = CAN_SAM_BR}, 0);
     
     printf("CAN initialized at 125 kbps\n");
     
@@ -497,11 +464,12 @@ void task7_servo_joystick_test(void) {
             msg_count++;
             
             // Try to decode joystick message
-            if (rx_msg.id == 0x100 && rx_msg.length == 5) {
+            if (PROTO_IS(rx_msg, PROTO_ID_JOYSTICK, proto_joystick_t)) {
                 // Extract joystick data
-                uint8_t joy_x = rx_msg.byte[0];
-                uint8_t joy_y = rx_msg.byte[1];
-                uint8_t joy_button = rx_msg.byte[2];
+                proto_joystick_t joy = PROTO_DECODE(proto_joystick_t, rx_msg);
+                uint8_t joy_x = joy.x;
+                uint8_t joy_y = joy.y;
+                uint8_t joy_button = joy.button;
                 
                 printf("Joystick: X=%d%% Y=%d%% Button=%s -> ", 
                        joy_x, joy_y, joy_button ? "PRESSED" : "Released");
@@ -49,16 +49,9 @@ void task7_joystick_servo_control(void) {
     
     // Initialize CAN to receive joystick data
     // Use the proven working CAN_BR configuration from Task 6
-    uint32_t working_can_br = 0x00290165;  // Proven working value
+    can_init((CanInit){.reg = CAN_SAM_BR}, 0);
     
-    can_init((CanInit){
-        .brp = 20, .propag = 2, .phase1 = 7, .phase2 = 6, .sjw = 1, .smp = 0
-    }, 0);
-    
-    // Override with exact working register value
-    CAN0->CAN_BR = working_can_br;
-    
-    printf("CAN initialized (CAN_BR = 0x%08X) - waiting for joystick data...\n\n", working_can_br);
+    printf("CAN initialized (CAN_BR = 0x%08lX) - waiting for joystick data...\n\n", (unsigned long)CAN_SAM_BR);
     
     CanMsg msg;
     uint8_t last_x_percent = 50; // Track changes
@@ -66,10 +59,9 @@ void task7_joystick_servo_control(void) {
     while (1) {
         // Check if we received a CAN message
         if (can_rx(&msg)) {
-            // Check if it's joystick data (ID = 0x00)
-            if (msg.id == 0x00 && msg.length >= 2) {
-                // Joystick data format: [X, Y, ?, Button, Slider]
-                uint8_t y_raw = msg.byte[1];  // Raw Y position (0-100) - ALREADY in percent!
+            // Check if it's joystick data (proto_joystick_t)
+            if (PROTO_IS(msg, PROTO_ID_JOYSTICK, proto_joystick_t)) {
+                uint8_t y_raw = PROTO_DECODE(proto_joystick_t, msg).y;  // Raw Y position (0-100) - ALREADY in percent!
                 
                 // Y is already 0-100%, just need to invert it
                 // Y=0 (top) should give 100% (2.1ms), Y=100 (bottom) should give 0% (0.9ms)
@@ -9,8 +9,10 @@
 #include "../motor.h"
 #include "../servo.h"
 #include "../can.h"
+#include "../can_stats.h"
 #include "../time.h"
 #include "../solenoid.h"
+#include "tlog.h"
 #include "../ir_sensor.h"
 #include "task8.h"
 
@@ -105,11 +107,7 @@ void task8_joystick_motor_control(void) {
     printf("Solenoid initialized\n");
     
     // Initialize CAN
-    uint32_t working_can_br = 0x00290165;
-    can_init((CanInit){
-        .brp = 20, .propag = 2, .phase1 = 7, .phase2 = 6, .sjw = 1, .smp = 0
-    }, 0);
-    CAN0->CAN_BR = working_can_br;
+    can_init((CanInit){.reg = CAN_SAM_BR}, 0);
     
     // Start with motor stopped
     motor_set_signed(0);
@@ -122,11 +120,12 @@ void task8_joystick_motor_control(void) {
     while (1) {
         // Check for CAN messages
         if (can_rx(&msg)) {
-            // Joystick data (ID = 0x00): [X, Y, JoyBtn, SliderX, SliderY]
-            if (msg.id == 0x00 && msg.length >= 3) {
-                uint8_t joy_x = msg.byte[0];      // X-axis for motor (0-100%)
-                uint8_t joy_y = msg.byte[1];      // Y-axis for servo (0-100%)
-                uint8_t joy_btn = msg.byte[2];    // Joystick button state (0=released, 1=pressed)
+            // Joystick data, see proto_joystick_t
+            if (PROTO_IS(msg, PROTO_ID_JOYSTICK, proto_joystick_t)) {
+                proto_joystick_t joy = PROTO_DECODE(proto_joystick_t, msg);
+                uint8_t joy_x = joy.x;            // X-axis for motor (0-100%)
+                uint8_t joy_y = joy.y;            // Y-axis for servo (0-100%)
+                uint8_t joy_btn = joy.button;     // Joystick button state (0=released, 1=pressed)
                 
                 // ========== SOLENOID CONTROL (Joystick Button) ==========
                 // Fire solenoid on joystick button press (rising edge detection)
@@ -201,9 +200,7 @@ void task8_motor_calibration(void) {
     printf("Solenoid initialized\n");
     
     // Initialize CAN
-    uint32_t working_can_br = 0x00290165;
-    can_init((CanInit){.brp=20, .propag=2, .phase1=7, .phase2=6, .sjw=1, .smp=0}, 0);
-    CAN0->CAN_BR = working_can_br;
+    can_init((CanInit){.reg = CAN_SAM_BR}, 0);
     time_spinFor(msecs(100));
     
     printf("\n*** STEP 1: MANUAL CENTERING ***\n");
@@ -216,9 +213,8 @@ void task8_motor_calibration(void) {
         CanMsg msg;
         if (can_rx(&msg)) {
             msg_count++;
-            if (msg.id == 0x00 && msg.length >= 3) {
-                uint8_t button = msg.byte[2];
-                if (button != 0) {
+            if (PROTO_IS_JOYSTICK(msg)) {
+                if (PROTO_DECODE(proto_joystick_t, msg).button != 0) {
                     button_pressed = true;
                     printf("Button pressed! Starting...\n");
                 }
@@ -294,6 +290,8 @@ void task8_motor_calibration(void) {
     uint32_t last_debug = time_now();
     uint8_t last_y = 255;
     uint8_t last_button = 0;
+    uint8_t joy_x = 50;
+    int16_t target = encoder_center;
     
     // Initialize IR sensor goal detection
     ir_sensor_init();
@@ -310,7 +308,76 @@ void task8_motor_calibration(void) {
     uint32_t intact_accumulator_ms = 0;
     uint32_t local_score = 0;
     
+    // Node 1 only sends joystick frames when the stick moves (plus a slow
+    // heartbeat), so frames are taken on every pass and the PI step runs on
+    // its own 20ms schedule instead of once per received frame.
+    uint64_t next_step = time_now();
+    
+    // Latency benchmark: stamped sample waiting for its motor command
+    bool echo_pending = false;
+    uint32_t echo_stamp_us = 0;
+    uint64_t echo_rx_time = 0;
+    
     while (1) {
+        // ========== CAN MESSAGE HANDLING ==========
+        CanMsg msg;
+        if (can_rx(&msg)) {                
+            uint64_t rx_time = time_now();
+            bool stamped = PROTO_IS(msg, PROTO_ID_JOYSTICK_STAMPED, proto_joystick_stamped_t);
+            if (PROTO_IS_JOYSTICK(msg)) {
+                proto_joystick_t joy = PROTO_DECODE(proto_joystick_t, msg);
+                uint8_t joy_y = joy.y;            // Y-axis for servo (0-100%)
+                uint8_t joy_btn = joy.button;     // Joystick button state (0=released, 1=pressed)
+                joy_x = joy.x;                    // X-axis for motor (0-100%)
+                
+                // ========== SOLENOID CONTROL (Joystick Button) ==========
+                // Fire solenoid on joystick button press (rising edge detection)
+                if (joy_btn && !last_button) {
+                    printf("FIRE! Solenoid activated\n");
+                    solenoid_fire(50);  // 50ms pulse
+                }
+                last_button = joy_btn;
+                
+                // ========== MOTOR TARGET (X-axis) ==========
+                target = min_encoder + (int16_t)(joy_x * scale_factor);
+                motor_pi_set_target(target);
+                
+                // ========== SERVO CONTROL (Y-axis) ==========
+                int8_t joy_y_centered = (int8_t)(joy_y - 50);
+                if (joy_y_centered > -5 && joy_y_centered < 5) {
+                    joy_y = 50;
+                }
+                
+                uint8_t servo_percent = 100 - joy_y;
+                
+                if (abs((int8_t)(joy_y - last_y)) > 3) {
+                    servo_set_position(servo_percent);
+                    last_y = joy_y;
+                }
+                
+                // ========== LATENCY BENCHMARK ==========
+                // The motor command only goes out at the next PI step, the echo
+                // waits for it so the round trip includes that scheduling delay
+                if (stamped) {
+                    echo_stamp_us = PROTO_DECODE(proto_joystick_stamped_t, msg).stamp_us;
+                    echo_rx_time = rx_time;
+                    echo_pending = true;
+                }
+            }
+        }
+        
+        // Rate limiting: 20ms per control step (50Hz control loop)
+        if (time_now() < next_step) {
+            continue;
+        }
+        next_step += msecs(20);
+        if (next_step <= time_now()) {
+            // A whole period behind (solenoid pulse, blocking printf, CAN TX timeout):
+            // resync instead of running the missed steps back to back with dt near zero
+            next_step = time_now() + msecs(20);
+        }
+        can_stats_service();
+        
         uint32_t now = time_now();
         uint32_t dt = (now >= last_time) ? (now - last_time) : 0;
         last_time = now;
@@ -332,15 +399,10 @@ void task8_motor_calibration(void) {
                 }
                 printf("*** GAME OVER - Returning to menu ***\n");
                 
-                // Send game over message to Node 1 (CAN ID 0x01)
-                CanMsg game_over_msg;
-                game_over_msg.id = 0x01;
-                game_over_msg.length = 4;
-                game_over_msg.byte[0] = 0xFF;  // Game over flag
-                game_over_msg.byte[1] = (local_score >> 24) & 0xFF;
-                game_over_msg.byte[2] = (local_score >> 16) & 0xFF;
-                game_over_msg.byte[3] = (local_score >> 8) & 0xFF;
-                can_tx(game_over_msg);
+                // Send game over message with the final score to Node 1
+                can_tx((CanMsg){
+                    PROTO_MSG(PROTO_ID_GAME_OVER, proto_game_over_t, .score = local_score)
+                });
                 
                 motor_set_signed(0);  // Stop motor
                 return;  // Exit back to menu
@@ -355,58 +417,31 @@ void task8_motor_calibration(void) {
                 intact_accumulator_ms -= 2000;
                 local_score++;
                 ir_sensor_increment_score();
-                printf("+++ Score +1  (total: %lu) +++\n", local_score);
+                TLOG("+++ Score +1  (total: %lu) +++\n", local_score);
             }
         }
 
-        // ========== CAN MESSAGE HANDLING ==========
-        CanMsg msg;
-        if (can_rx(&msg)) {                
-            if (msg.id == 0x00 && msg.length >= 3) {
-                uint8_t joy_x = msg.byte[0];      // X-axis for motor (0-100%)
-                uint8_t joy_y = msg.byte[1];      // Y-axis for servo (0-100%)
-                uint8_t joy_btn = msg.byte[2];    // Joystick button state (0=released, 1=pressed)
-                
-                // ========== SOLENOID CONTROL (Joystick Button) ==========
-                // Fire solenoid on joystick button press (rising edge detection)
-                if (joy_btn && !last_button) {
-                    printf("FIRE! Solenoid activated\n");
-                    solenoid_fire(50);  // 50ms pulse
-                }
-                last_button = joy_btn;
-                
-                // ========== MOTOR CONTROL (PI Position Control) ==========
-                int16_t target = min_encoder + (int16_t)(joy_x * scale_factor);
-                motor_pi_set_target(target);
-                
-                int16_t position = encoder_read();
-                int8_t motor_cmd = motor_pi_update(position);
-                motor_set_signed(motor_cmd);
-                
-                // ========== SERVO CONTROL (Y-axis) ==========
-                int8_t joy_y_centered = (int8_t)(joy_y - 50);
-                if (joy_y_centered > -5 && joy_y_centered < 5) {
-                    joy_y = 50;
-                }
-                
-                uint8_t servo_percent = 100 - joy_y;
-                
-                if (abs((int8_t)(joy_y - last_y)) > 3) {
-                    servo_set_position(servo_percent);
-                    last_y = joy_y;
-                }
-                
-                // Debug every 500ms
-                if ((now - last_debug) >= 500) {
-                    int16_t error = target - position;
-                    printf("Joy:%3d Tgt:%4d Pos:%4d Err:%4d Mot:%4d%%\n", 
-                           joy_x, target, position, error, motor_cmd);
-                    last_debug = now;
-                }
-            }
+        // ========== MOTOR CONTROL (PI Position Control) ==========
+        int16_t position = encoder_read();
+        int8_t motor_cmd = motor_pi_update(position);
+        motor_set_signed(motor_cmd);
+        
+        // Command applied: hand Node 1 its stamp back for the round trip
+        if (echo_pending) {
+            can_tx((CanMsg){
+                PROTO_MSG(PROTO_ID_LATENCY_ECHO, proto_latency_echo_t,
+                    .stamp_us = echo_stamp_us,
+                    .service_us = (uint16_t)totalUsecs(time_now() - echo_rx_time))
+            });
+            echo_pending = false;
         }
         
-        // Rate limiting: 20ms per loop iteration (50Hz control loop)
-        time_spinFor(msecs(20));
+        // Debug every 500ms
+        if ((now - last_debug) >= 500) {
+            int16_t error = target - position;
+            TLOG("Joy:%3d Tgt:%4d Pos:%4d Err:%4d Mot:%4d%%\n",
+                 joy_x, target, position, error, motor_cmd);
+            last_debug = now;
+        }
     }
 }
@@ -0,0 +1,25 @@
+// Node 2 side of the tokenized logger (common/tlog.h)
+#define TLOG_IMPLEMENTATION
+#include "tlog.h"
+#include "sam.h"
+#include "uart.h"
+#include "time.h"
+
+uint32_t tlog_timestamp_ms(void){
+    return (uint32_t)(time_now() / msecs(1));
+}
+
+// Whole frame into the transmit buffer or nothing, so a record is never cut by other output
+uint8_t tlog_output(const uint8_t* frame, uint8_t length){
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if(uart_tx_free() < length){
+        __set_PRIMASK(primask);
+        return 0;
+    }
+    for(uint8_t i = 0; i < length; i++){
+        uart_tx(frame[i]);
+    }
+    __set_PRIMASK(primask);
+    return 1;
+}
@@ -14,6 +14,16 @@ struct RingBuf {
 };
 RingBuf ringBuf = {0};
 
+// Transmit ring, drained by the TXRDY interrupt so printf does not wait for the line
+#define UART_TX_BUFFER_SIZE 256
+static volatile uint8_t txBuffer[UART_TX_BUFFER_SIZE];
+static volatile uint16_t txHead = 0;    // Next free slot
+static volatile uint16_t txTail = 0;    // Next byte to send
+
+// Received bytes dropped because the receive ring was full (counted in the interrupt,
+// which must not printf: that would interleave with the main loop's writes to txHead)
+static volatile uint32_t rxOverflows = 0;
+
 
 int push(RingBuf* rb, uint8_t val){
     if(rb->length >= (sizeof(rb->buffer)/sizeof(rb->buffer[0]))){
@@ -59,8 +69,33 @@ void uart_init(uint32_t cpufreq, uint32_t baudrate){
 }    
 
 void uart_tx(uint8_t val){
-    while(!(UART->UART_SR & UART_SR_TXEMPTY)){}
-    UART->UART_THR = val;
+    for(;;){
+        // Interrupts off around the head update: any context may write here
+        uint32_t primask = __get_PRIMASK();
+        __disable_irq();
+        uint16_t next = (txHead + 1) % UART_TX_BUFFER_SIZE;
+        if(next != txTail){
+            txBuffer[txHead] = val;
+            txHead = next;
+            UART->UART_IER = UART_IER_TXRDY;
+            __set_PRIMASK(primask);
+            return;
+        }
+        __set_PRIMASK(primask);
+        
+        // Full: wait for the interrupt to make room, unless it cannot run (drop instead)
+        if(__get_IPSR() != 0 || primask){
+            return;
+        }
+    }
+}
+
+uint16_t uart_tx_free(void){
+    return (txTail + UART_TX_BUFFER_SIZE - txHead - 1) % UART_TX_BUFFER_SIZE;
+}
+
+uint32_t uart_rx_overflows(void){
+    return rxOverflows;
 }
 
 uint8_t uart_rx(uint8_t* val){
@@ -88,10 +123,20 @@ void UART_Handler(){
         UART->UART_CR = UART_CR_RXEN | UART_CR_TXEN | UART_CR_RSTSTA;
     }
     
+    // Transmit ready: next byte from the ring, stop when it is empty
+    if((status & UART_SR_TXRDY) && (UART->UART_IMR & UART_IMR_TXRDY)){
+        if(txHead == txTail){
+            UART->UART_IDR = UART_IDR_TXRDY;
+        } else {
+            UART->UART_THR = txBuffer[txTail];
+            txTail = (txTail + 1) % UART_TX_BUFFER_SIZE;
+        }
+    }
+    
     // Receive ready: push to ring buffer
     if(status & UART_SR_RXRDY){
         if(!push(&ringBuf, UART->UART_RHR & 0xff)){
-            printf("UART receive buffer full\n");
+            rxOverflows++;
         }
     }
     
@@ -13,10 +13,16 @@
 // Initialize. Hooks stdio functions (like `printf`)
 void uart_init(uint32_t cpufreq, uint32_t baudrate);
 
-// Send a single character
+// Send a single character (queued, waits only while the transmit buffer is full)
 // Prefer using `printf` instead
 void uart_tx(uint8_t val);
 
+// Free space in the transmit buffer
+uint16_t uart_tx_free(void);
+
+// Received characters dropped because the receive buffer was full
+uint32_t uart_rx_overflows(void);
+
 // Read a single character
 // Prefer using `uart_flush` and `sscanf` instead (see below)
 uint8_t uart_rx(uint8_t* val);
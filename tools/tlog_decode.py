@@ -0,0 +1,253 @@
+#!/usr/bin/env python3
+"""
+Decode tokenized log output (common/tlog.h) from either node.
+
+Reads the serial stream, prints ordinary text unchanged and replaces every
+TLOG frame with its formatted text. Format strings are looked up in the
+firmware ELF (the `tlog_fmt_*` symbols), or in a table written earlier with
+--dump-table.
+
+    python3 tools/tlog_decode.py node-1/build/a.out < /dev/ttyS0
+    python3 tools/tlog_decode.py node-2/build/main.elf --port /dev/ttyACM0 --baud 9600
+    python3 tools/tlog_decode.py node-1/build/a.out --dump-table tokens.json
+    python3 tools/tlog_decode.py --table tokens.json capture.bin
+"""
+
+import argparse
+import json
+import re
+import struct
+import sys
+
+FRAME_START = 0x1E
+SYMBOL_PREFIX = "tlog_fmt_"
+
+EM_AVR = 83
+EM_ARM = 40
+
+# Token base and `int` size per target, must match TLOG_ID_BASE in common/tlog.h
+TARGETS = {
+    EM_AVR: {"base": 0x0000, "int_bits": 16},
+    EM_ARM: {"base": 0x80000, "int_bits": 32},
+}
+
+CONVERSION = re.compile(r"%([-+ #0]*\d*(?:\.\d+)?)(hh|h|ll|l|z|j|t)?([diouxXcfFeEgGs%])")
+
+
+# === ELF ===
+
+def read_elf_tokens(path):
+    """Return ({token: format}, target) from the symbols of an ELF file."""
+    with open(path, "rb") as f:
+        data = f.read()
+
+    if data[:4] != b"\x7fELF":
+        sys.exit("%s is not an ELF file" % path)
+    is64 = data[4] == 2
+    if data[5] != 1:
+        sys.exit("big-endian ELF files are not supported")
+
+    if is64:
+        machine, = struct.unpack_from("<H", data, 18)
+        shoff, = struct.unpack_from("<Q", data, 40)
+        shentsize, shnum = struct.unpack_from("<HH", data, 58)
+    else:
+        machine, = struct.unpack_from("<H", data, 18)
+        shoff, = struct.unpack_from("<I", data, 32)
+        shentsize, shnum = struct.unpack_from("<HH", data, 46)
+
+    sections = []
+    for i in range(shnum):
+        off = shoff + i * shentsize
+        if is64:
+            name, stype, flags, addr, offset, size, link, _, _, entsize = \
+                struct.unpack_from("<IIQQQQIIQQ", data, off)
+        else:
+            name, stype, flags, addr, offset, size, link, _, _, entsize = \
+                struct.unpack_from("<IIIIIIIIII", data, off)
+        sections.append(dict(type=stype, flags=flags, addr=addr, offset=offset,
+                             size=size, link=link, entsize=entsize))
+
+    symtab = next((s for s in sections if s["type"] == 2), None)  # SHT_SYMTAB
+    if symtab is None:
+        sys.exit("%s has no symbol table (stripped?)" % path)
+    strtab = sections[symtab["link"]]
+
+    def c_string(offset):
+        end = data.index(b"\0", offset)
+        return data[offset:end].decode("utf-8", "replace")
+
+    def read_at(addr):
+        # Loaded sections with file contents (SHF_ALLOC, not NOBITS)
+        for s in sections:
+            if s["flags"] & 0x2 and s["type"] != 8 and s["addr"] <= addr < s["addr"] + s["size"]:
+                return c_string(s["offset"] + addr - s["addr"])
+        return None
+
+    target = TARGETS.get(machine)
+    tokens = {}
+    entsize = symtab["entsize"] or (24 if is64 else 16)
+    for i in range(symtab["size"] // entsize):
+        off = symtab["offset"] + i * entsize
+        if is64:
+            name, _, _, _, value, _ = struct.unpack_from("<IBBHQQ", data, off)
+        else:
+            name, value, _, _, _, _ = struct.unpack_from("<IIIBBH", data, off)
+        if not c_string(strtab["offset"] + name).startswith(SYMBOL_PREFIX):
+            continue
+        text = read_at(value)
+        if text is None:
+            continue
+        token = value - (target["base"] if target else 0)
+        if token in tokens and tokens[token] != text:
+            print("warning: token 0x%x is ambiguous" % token, file=sys.stderr)
+        tokens[token] = text
+    return tokens, target
+
+
+# === Frames ===
+
+def cobs_decode(data):
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        code = data[i]
+        if code == 0 or i + code > len(data):
+            raise ValueError("bad COBS code")
+        out += data[i + 1:i + code]
+        i += code
+        if code < 0xFF and i < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+def read_varint(data, pos):
+    value = shift = 0
+    while True:
+        if pos >= len(data):
+            raise ValueError("truncated varint")
+        byte = data[pos]
+        pos += 1
+        value |= (byte & 0x7F) << shift
+        shift += 7
+        if not byte & 0x80:
+            return value, pos
+
+
+def read_int(data, pos):
+    raw, pos = read_varint(data, pos)
+    return (raw >> 1) ^ -(raw & 1), pos
+
+
+def format_record(fmt, data, pos, int_bits):
+    """printf the recorded arguments with the format's conversions."""
+    out = []
+    last = 0
+    for m in CONVERSION.finditer(fmt):
+        out.append(fmt[last:m.start()])
+        last = m.end()
+        flags, length, conv = m.groups()
+        if conv == "%":
+            out.append("%")
+            continue
+        if conv == "s":
+            out.append("<%s unsupported>")
+            continue
+        if conv in "fFeEgG":
+            value, = struct.unpack_from("<f", data, pos)
+            pos += 4
+        else:
+            value, pos = read_int(data, pos)
+            bits = {"hh": 8, "h": 16, "l": 32, "ll": 32}.get(length, int_bits)
+            if conv in "ouxX":
+                value &= (1 << bits) - 1
+            elif conv == "c":
+                value &= 0xFF
+            else:
+                value = ((value + (1 << (bits - 1))) & ((1 << bits) - 1)) - (1 << (bits - 1))
+        out.append(("%" + flags + ("d" if conv == "u" else conv)) % value)
+    out.append(fmt[last:])
+    return "".join(out)
+
+
+def decode_frame(frame, tokens, int_bits):
+    record = cobs_decode(frame)
+    token, pos = read_varint(record, 0)
+    stamp, pos = read_varint(record, pos)
+    fmt = tokens.get(token)
+    if fmt is None:
+        return "[%10.3f] <unknown token 0x%x>\n" % (stamp / 1000.0, token)
+    return "[%10.3f] %s" % (stamp / 1000.0, format_record(fmt, record, pos, int_bits))
+
+
+def decode_stream(stream, tokens, int_bits, out):
+    frame = None
+    while True:
+        chunk = stream.read(1)
+        if not chunk:
+            break
+        byte = chunk[0]
+        if frame is None:
+            if byte == FRAME_START:
+                frame = bytearray()
+            else:
+                out.write(chr(byte))
+        elif byte == 0:
+            try:
+                out.write(decode_frame(bytes(frame), tokens, int_bits))
+            except (ValueError, struct.error) as e:
+                out.write("<bad frame: %s>\n" % e)
+            frame = None
+        else:
+            frame.append(byte)
+        out.flush()
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("elf", nargs="?", help="firmware ELF with the tlog_fmt_ symbols")
+    parser.add_argument("input", nargs="?", help="captured stream (default: stdin)")
+    parser.add_argument("--table", help="token table from --dump-table instead of an ELF")
+    parser.add_argument("--dump-table", metavar="FILE", help="write the ELF's token table as JSON and exit")
+    parser.add_argument("--port", help="read from a serial port (needs pyserial)")
+    parser.add_argument("--baud", type=int, default=38400)
+    parser.add_argument("--int-bits", type=int, help="size of int on the target (default from the ELF)")
+    args = parser.parse_args()
+
+    if args.table:
+        with open(args.table) as f:
+            table = json.load(f)
+        tokens = {int(k, 0): v for k, v in table["tokens"].items()}
+        int_bits = table["int_bits"]
+        if args.elf and not args.input:
+            args.input = args.elf   # Only the capture was given
+    elif args.elf:
+        tokens, target = read_elf_tokens(args.elf)
+        int_bits = target["int_bits"] if target else 32
+    else:
+        parser.error("need an ELF file or --table")
+    if args.int_bits:
+        int_bits = args.int_bits
+
+    if args.dump_table:
+        with open(args.dump_table, "w") as f:
+            json.dump({"int_bits": int_bits,
+                       "tokens": {"0x%x" % k: v for k, v in sorted(tokens.items())}}, f, indent=2)
+        print("%d format strings written to %s" % (len(tokens), args.dump_table))
+        return
+
+    if args.port:
+        import serial
+        stream = serial.Serial(args.port, args.baud)
+    elif args.input:
+        stream = open(args.input, "rb")
+    else:
+        stream = sys.stdin.buffer
+    try:
+        decode_stream(stream, tokens, int_bits, sys.stdout)
+    except KeyboardInterrupt:
+        pass
+
+
+if __name__ == "__main__":
+    main()